@@ -2,6 +2,7 @@
 
 #include <nesemu/hw/apu/apu_clock.h>
 #include <nesemu/hw/apu/channels.h>
+#include <nesemu/hw/state.h>
 #include <nesemu/utils/reg_bit.h>
 
 #include <array>
@@ -9,8 +10,8 @@
 
 
 // Forward declarations
-namespace ui {
-class Speaker;
+namespace hw::io {
+class AudioSink;
 }
 
 
@@ -34,23 +35,29 @@ union StatusControl {
 class APU {
 public:
   // Setup
-  void setSpeaker(ui::Speaker* speaker);
+  void setSpeaker(io::AudioSink* speaker);
 
   // Execution
-  void    clock();
-  bool    hasIRQ() const { return has_irq_ || dmc.hasIRQ(); }
-  uint8_t readRegister(uint16_t address);
-  void    writeRegister(uint16_t address, uint8_t data);
+  void     clock();
+  void     run(uint32_t cycles);  // Clock the APU this many times
+  bool     hasIRQ() const { return has_irq_ || dmc.hasIRQ(); }
+  uint32_t cyclesUntilEvent() const;  // Cycles to clock until the CPU could see a change, eg. IRQ. May undercount
+  uint8_t  readRegister(uint16_t address);
+  void     writeRegister(uint16_t address, uint8_t data);
 
   // DMC DMA
   bool     DMAActive() const { return dmc.DMAActive(); };
   uint16_t DMAAddr() const { return dmc.DMAAddr(); }
   void     DMAPush(uint8_t data) { dmc.DMAPush(data); }
 
+  // Save states
+  void saveState(state::Writer* out) const;
+  void loadState(state::Reader* in);
+
 
 private:
   // Other chips
-  ui::Speaker* speaker_ = {nullptr};
+  io::AudioSink* speaker_ = {nullptr};
 
   inline void clockFrame(APUClock clock_type);
 
@@ -2,6 +2,7 @@
 
 #include <nesemu/hw/apu/apu_clock.h>
 #include <nesemu/hw/apu/units.h>
+#include <nesemu/hw/state.h>
 #include <nesemu/utils/reg_bit.h>
 
 #include <cstdint>
@@ -20,6 +21,10 @@ public:
   virtual void    clockFrame(APUClock clock_type)     = 0;
   virtual uint8_t getOutput() const                   = 0;
 
+  // Save states. Channels which override these call the base class first
+  virtual void saveState(state::Writer* out) const { out->put(enabled_); }
+  virtual void loadState(state::Reader* in) { in->get(enabled_); }
+
 protected:
   bool enabled_ = {false};
 };
@@ -35,6 +40,15 @@ public:
   }
   virtual bool status() const override { return length_counter_.counter_ > 0; }
 
+  virtual void saveState(state::Writer* out) const override {
+    Channel::saveState(out);
+    length_counter_.saveState(out);
+  }
+  virtual void loadState(state::Reader* in) override {
+    Channel::loadState(in);
+    length_counter_.loadState(in);
+  }
+
 protected:
   unit::LengthCounter length_counter_;
 };
@@ -63,13 +77,15 @@ public:
   void    clockCPU() override;
   void    clockFrame(APUClock clock_type) override;
   uint8_t getOutput() const override;
+  void    saveState(state::Writer* out) const override;
+  void    loadState(state::Reader* in) override;
 
 private:
   static constexpr uint8_t SEQUENCE[4] = {0b01000000, 0b01100000, 0b01111000, 0b10011111};
 
   bool     clock_is_even_ = {false};
-  uint8_t  duty_cycle_;  // 2-bit. 12.5%, 25%, 50%, or -25%
-  uint16_t period_;      // 11-bit. Used to reload timer.
+  uint8_t  duty_cycle_    = {0};  // 2-bit. 12.5%, 25%, 50%, or -25%
+  uint16_t period_        = {0};  // 11-bit. Used to reload timer.
 
   unit::Divider<uint16_t>     timer_;  // 11-bit
   unit::Sequencer<uint8_t, 8> sequencer_;
@@ -94,12 +110,14 @@ public:
   void    clockCPU() override;
   void    clockFrame(APUClock clock_type) override;
   uint8_t getOutput() const override { return SEQUENCE[sequencer_.get()]; };
+  void    saveState(state::Writer* out) const override;
+  void    loadState(state::Reader* in) override;
 
 private:
   static constexpr uint8_t SEQUENCE[32] = {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5,  4,  3,  2,  1,  0,
                                            0,  1,  2,  3,  4,  5,  6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
 
-  uint16_t period_;  // 11-bit. Used to reload timer.
+  uint16_t period_ = {0};  // 11-bit. Used to reload timer.
 
   unit::Divider<uint16_t>      timer_;  // 11-bit
   unit::Sequencer<uint8_t, 32> sequencer_;
@@ -121,6 +139,8 @@ public:
   void    clockCPU() override;
   void    clockFrame(APUClock clock_type) override;
   uint8_t getOutput() const override;
+  void    saveState(state::Writer* out) const override;
+  void    loadState(state::Reader* in) override;
 
 private:
   static constexpr uint16_t PERIODS[16] = {4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068};
@@ -149,6 +169,8 @@ struct DMC : public Channel {
   void    clockCPU() override;
   void    clockFrame(APUClock /*clock_type*/) override {};
   uint8_t getOutput() const override { return output_ & 0x7F; };
+  void    saveState(state::Writer* out) const override;
+  void    loadState(state::Reader* in) override;
 
   bool hasIRQ() const { return has_irq_; }
 
@@ -156,14 +178,15 @@ struct DMC : public Channel {
   bool     DMAActive() const { return dma_active_; };
   uint16_t DMAAddr() const { return dma_address_; }
   void     DMAPush(uint8_t data);
+  uint32_t cyclesUntilDMA() const;  // CPU cycles to clock before a DMA could be requested. May undercount
 
 private:
   static constexpr uint16_t PERIODS[16] = {428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54};
 
-  bool     loop_;
-  bool     IRQ_enable_;
-  uint16_t sample_address_;
-  uint16_t sample_length_;
+  bool     loop_           = {false};
+  bool     IRQ_enable_     = {false};
+  uint16_t sample_address_ = {0};
+  uint16_t sample_length_  = {0};
 
   // Timer cannot be stopped
   unit::Divider<uint16_t> timer_;
@@ -171,18 +194,18 @@ private:
   // DMA
   // A DMA read is initiated by setting dma_active_. The CPU sees this, stalls appropriately, and returns the result
   // when ready via DMAPush(). This means it's more CPU-driven than DMA-driven, but this is easier for inserting stalls
-  bool     dma_active_ = {false};
-  uint16_t dma_address_;
-  uint16_t dma_remaining_;  // In bytes
-  uint8_t  sample_buffer_;
-  bool     has_sample_;
+  bool     dma_active_    = {false};
+  uint16_t dma_address_   = {0};
+  uint16_t dma_remaining_ = {0};  // In bytes
+  uint8_t  sample_buffer_ = {0};
+  bool     has_sample_    = {false};
 
   // Output
-  uint8_t bits_remaining_;
-  uint8_t bit_buffer_;    // Right shift register
-  uint8_t output_ = {0};  // 7 bits
-  bool    silence_;
-  bool    has_irq_;
+  uint8_t bits_remaining_ = {0};
+  uint8_t bit_buffer_     = {0};  // Right shift register
+  uint8_t output_         = {0};  // 7 bits
+  bool    silence_        = {false};
+  bool    has_irq_        = {false};
 };
 
 }  // namespace hw::apu::channel
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <nesemu/hw/state.h>
+
 #include <cstddef>
 #include <cstdint>
 
@@ -17,10 +19,12 @@ namespace hw::apu::unit {
 template <class T = uint8_t>
 class Divider {
 public:
-  void setLoop(bool loop) { loop_ = loop; }                           ///< Whether to loop when the counter reaches 0
-  void setPeriod(T period) { period_ = period; }                      ///< Set divider period
-  void setExtPeriod(T* ext_period) { ext_period_ = ext_period; }      ///< Set external divider period
-  void reload() { counter_ = ext_period_ ? *ext_period_ : period_; }  ///< Reload divider with period
+  void setLoop(bool loop) { loop_ = loop; }                             ///< Whether to loop when the counter reaches 0
+  void setPeriod(T period) { period_ = period; }                        ///< Set divider period
+  void setExtPeriod(T* ext_period) { ext_period_ = ext_period; }        ///< Set external divider period
+  void reload() { counter_ = ext_period_ ? *ext_period_ : period_; }    ///< Reload divider with period
+  T    period() const { return ext_period_ ? *ext_period_ : period_; }  ///< Current divider period
+  T    counter() const { return counter_; }                             ///< Next output is counter() + 1 clocks away
   bool clock() {  ///< If 0, reload and return true. Otherwise, decrement and return false
 
     if (counter_ == 0) {
@@ -34,6 +38,18 @@ public:
     return false;
   }
 
+  // The external period belongs to the channel, which saves it
+  void saveState(state::Writer* out) const {
+    out->put(loop_);
+    out->put(period_);
+    out->put(counter_);
+  }
+  void loadState(state::Reader* in) {
+    in->get(loop_);
+    in->get(period_);
+    in->get(counter_);
+  }
+
 private:
   bool loop_       = {true};
   T    period_     = {0};
@@ -57,13 +73,15 @@ class Envelope {
 public:
   Divider<uint8_t> divider_;  // 4-bit divider. Max = 15
 
-  uint8_t volume_;           // 4-bit. The volume of the channel, if not using envelope
-  bool    const_volume_;     // 1=Constant volume, 0=Envelope volume
-  bool    loop_  = {false};  // Whether to loop when the decay level reaches 0
-  bool    start_ = {false};  // Flag to indicate restart
+  uint8_t volume_       = {0};      // 4-bit. The volume of the channel, if not using envelope
+  bool    const_volume_ = {false};  // 1=Constant volume, 0=Envelope volume
+  bool    loop_         = {false};  // Whether to loop when the decay level reaches 0
+  bool    start_        = {false};  // Flag to indicate restart
 
   void    clock();
   uint8_t getOutput() const { return const_volume_ ? volume_ : decay_level_; }
+  void    saveState(state::Writer* out) const;
+  void    loadState(state::Reader* in);
 
 private:
   uint8_t decay_level_ = {0};  // 4-bit. 0 to 15. The current decay level
@@ -103,6 +121,8 @@ public:
   void     clock();
   uint16_t getTarget() const;
   uint8_t  getOutput(uint8_t input) const;
+  void     saveState(state::Writer* out) const;  // Not the channel period, which belongs to the channel
+  void     loadState(state::Reader* in);
 
 private:
   bool mute() const;
@@ -125,6 +145,8 @@ public:
   void    load(uint8_t code);
   void    clock();
   uint8_t getOutput(uint8_t input) const;
+  void    saveState(state::Writer* out) const;
+  void    loadState(state::Reader* in);
 };
 
 
@@ -144,6 +166,8 @@ public:
 
   void    clock();
   uint8_t getOutput(uint8_t input) const;
+  void    saveState(state::Writer* out) const;
+  void    loadState(state::Reader* in);
 };
 
 
@@ -160,6 +184,8 @@ public:
   void      reset() { pos_ = 0; };
   void      clock() { pos_ = (pos_ + 1) % SEQ_LEN; };
   virtual T get() const { return pos_; };
+  void      saveState(state::Writer* out) const { out->put(pos_); }
+  void      loadState(state::Reader* in) { in->get(pos_); }
 
 private:
   T pos_ = 0;
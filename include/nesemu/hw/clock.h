@@ -2,6 +2,37 @@
 
 #include <nesemu/utils/steady_timer.h>
 
+#include <chrono>
+
+
 namespace hw::clock {
-class CPUClock : public utils::SteadyTimer<22, 39375000> {};  // ~1.79MHz
+
+// How often the emulation is synchronized to real time. Coarser pacing is much cheaper, at the cost of the emulated
+// hardware running in bursts
+enum class Pacing {
+  CYCLE,     // Wait after every CPU cycle
+  SCANLINE,  // Wait after every ~114 CPU cycles
+  FRAME      // Wait after every ~29781 CPU cycles
+};
+
+class CPUClock : public utils::SteadyTimer<22, 39375000> {  // ~1.79MHz
+public:
+  CPUClock() { setPacing(Pacing::FRAME); }
+
+  void setPacing(Pacing pacing) {
+    using namespace std::chrono_literals;
+    switch (pacing) {
+      case Pacing::CYCLE:
+        setInterval(1, 0us);
+        break;
+      case Pacing::SCANLINE:
+        setInterval(114, 50us);  // 341/3 CPU cycles per scanline
+        break;
+      case Pacing::FRAME:
+        setInterval(29781, 1ms);  // 262*341/3 CPU cycles per frame
+        break;
+    }
+  }
+};
+
 }  // namespace hw::clock
@@ -5,62 +5,182 @@
 #include <nesemu/hw/cpu.h>
 #include <nesemu/hw/joystick.h>
 #include <nesemu/hw/ppu.h>
+#include <nesemu/hw/state.h>
 #include <nesemu/hw/system_bus.h>
+#include <nesemu/logger.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 
 // Forward declarations
-namespace hw::mapper {
-class Mapper;
-}
+namespace hw::io {
+class AudioSink;
+class InputSource;
+class VideoSink;
+}  // namespace hw::io
 
 namespace hw::rom {
 class Rom;
 }
 
-namespace ui {
-class Screen;
-class Speaker;
-}  // namespace ui
-
 
 namespace hw::console {
 
+// The console is specialised on the cartridge's mapper class (see internal::Console), so it is created through
+// create() rather than constructed directly
 class Console {
+public:
+  virtual ~Console() = default;
+
+  // Setup
+  virtual void setScreen(io::VideoSink* screen)   = 0;
+  virtual void setSpeaker(io::AudioSink* speaker) = 0;
+  virtual void setInput(io::InputSource* input)   = 0;
+  virtual void setLogLevel(logger::Level level)   = 0;  // Defaults to the level of the thread which created it
+
+  // Execution
+  virtual void     start()                          = 0;
+  virtual void     update()                         = 0;  // Execute a single instruction, or block (see setBackend)
+  virtual void     runFrame()                       = 0;  // Run until the PPU reaches the post-render scanline
+  virtual uint64_t runCycles(uint64_t cycles)       = 0;  // Run for at least this many CPU cycles. Returns cycles run
+  virtual void     reset(bool reset)                = 0;
+  virtual void     limitSpeed(bool limit)           = 0;
+  virtual void     setPacing(clock::Pacing pacing)  = 0;
+  virtual void     setSpeed(double speed)           = 0;  // Scale the emulation speed, 1.0 = realtime
+  virtual void     setBackend(cpu::Backend backend) = 0;
+  virtual void     skipIdleLoops(bool skip)         = 0;  // Fast-forward through loops waiting for interrupts
+  virtual void     setRenderer(ppu::Renderer r)     = 0;
+  virtual void     setFrameSkip(uint32_t ratio)     = 0;  // Draw every ratio-th frame. 0 = only when requested
+  virtual void     renderNextFrame()                = 0;  // Draw the next frame to start, whatever the skip ratio
+
+  // Save states (see state.h), of everything but the screen buffer. A state can only be loaded into a console with the
+  // same cartridge. Loading returns non-zero if the state is for another cartridge or version, leaving the console as
+  // it was
+  virtual void saveState(std::vector<uint8_t>* state)      = 0;
+  virtual int  loadState(const std::vector<uint8_t>& state) = 0;
+
+  // Snapshots, ie. for rolling back. A snapshot is a save state, but restoring it only checks its size, so it must come
+  // from a console with the same cartridge. Neither allocates once the buffer is big enough, so both are a few copies
+  virtual void snapshot(std::vector<uint8_t>* buffer)      = 0;
+  virtual int  restore(const std::vector<uint8_t>& buffer) = 0;  // Returns non-zero if the buffer is the wrong size
+
+  // Run until done() returns true, or until a step passes no cycles, so a console which can't make progress still
+  // returns. The predicate is checked between instructions (or blocks, see setBackend). Unlike runFrame() and
+  // runCycles(), this may leave the other chips behind the CPU (see system_bus::SystemBus)
+  template <class Predicate>
+  void runUntil(Predicate done) {
+    while (!done()) {
+      const uint64_t cycles = getCycles();
+      update();
+      if (getCycles() == cycles) {
+        return;
+      }
+    }
+  }
+
+  // Misc
+  virtual const ppu::PPU*          getPPU() const           = 0;
+  virtual uint64_t                 getCycles() const        = 0;
+  virtual uint64_t                 getFrameCount() const    = 0;
+  virtual const utils::TimerStats& getPacingStats() const   = 0;
+  virtual cpu::Registers           getRegisters() const     = 0;
+  virtual uint64_t                 getSkippedCycles() const = 0;  // CPU cycles fast-forwarded, see skipIdleLoops
+};
+
+
+// Create a console with the given cartridge loaded, specialised for its mapper. If generic is set, the mapper is called
+// through its vtable instead, which is slower but lets the two be compared. Returns nullptr if the mapper is not
+// supported
+Console* create(rom::Rom* rom, bool allow_unofficial_opcodes, bool generic = false);
+
+
+namespace internal {
+
+template <class MapperT>
+class Console final : public console::Console {
 public:
   explicit Console(bool allow_unofficial_opcodes);
   ~Console();
 
   // Setup
-  void loadCart(rom::Rom* rom);
-  void setScreen(ui::Screen* screen);
-  void setSpeaker(ui::Speaker* speaker);
+  int  loadCart(rom::Rom* rom);
+  void setScreen(io::VideoSink* screen) override;
+  void setSpeaker(io::AudioSink* speaker) override;
+  void setInput(io::InputSource* input) override;
+  void setLogLevel(logger::Level level) override { log_level_ = level; }
 
   // Execution
-  void start();
-  void update();
-  void reset(bool reset);
-  void limitSpeed(bool limit) { clock_.skip(!limit); };
+  void     start() override;
+  void     update() override;
+  void     runFrame() override;
+  uint64_t runCycles(uint64_t cycles) override;
+  void     reset(bool reset) override;
+  void     limitSpeed(bool limit) override { clock_.skip(!limit); };
+  void     setPacing(clock::Pacing pacing) override { clock_.setPacing(pacing); }
+  void     setSpeed(double speed) override { clock_.setRate(speed); }
+  void     setBackend(cpu::Backend backend) override { backend_ = backend; }
+  void     skipIdleLoops(bool skip) override { cpu_.skipIdleLoops(skip); }
+  void     setRenderer(ppu::Renderer r) override { ppu_.setRenderer(r); }
+  void     setFrameSkip(uint32_t ratio) override { ppu_.setFrameSkip(ratio); }
+  void     renderNextFrame() override { ppu_.renderNextFrame(); }
+
+  // Save states
+  void saveState(std::vector<uint8_t>* state) override { snapshot(state); }
+  int  loadState(const std::vector<uint8_t>& state) override;
+  void snapshot(std::vector<uint8_t>* buffer) override;
+  int  restore(const std::vector<uint8_t>& buffer) override;
 
   // Misc
-  const ppu::PPU* getPPU() const { return &ppu_; }
+  const ppu::PPU*          getPPU() const override { return &ppu_; }
+  uint64_t                 getCycles() const override { return bus_.cycles(); }
+  uint64_t                 getFrameCount() const override { return ppu_.frameCount(); }
+  const utils::TimerStats& getPacingStats() const override { return clock_.stats(); }
+  cpu::Registers           getRegisters() const override { return cpu_.registers(); }
+  uint64_t                 getSkippedCycles() const override { return cpu_.skippedCycles(); }
 
 private:
-  ui::Screen*  screen_  = {nullptr};
-  ui::Speaker* speaker_ = {nullptr};
+  io::VideoSink*   screen_  = {nullptr};
+  io::AudioSink*   speaker_ = {nullptr};
+  io::InputSource* input_   = {nullptr};
 
   // HW Components
-  system_bus::SystemBus bus_;
-  apu::APU              apu_;
-  cpu::CPU              cpu_;
-  ppu::PPU              ppu_;
-  joystick::Joystick    joy_1_  = {1};
-  joystick::Joystick    joy_2_  = {2};
-  mapper::Mapper*       mapper_ = {nullptr};
+  system_bus::SystemBus<MapperT> bus_;
+  apu::APU                       apu_;
+  cpu::CPU<MapperT>              cpu_;
+  ppu::internal::PPU<MapperT>    ppu_;
+  joystick::Joystick             joy_1_  = {1};
+  joystick::Joystick             joy_2_  = {2};
+  MapperT*                       mapper_ = {nullptr};
 
   // System clock
   clock::CPUClock clock_;
 
-  bool reset_ = {false};
+  bool          reset_     = {false};
+  cpu::Backend  backend_   = {cpu::Backend::INTERPRETER};
+  logger::Level log_level_ = {logger::level};  // Swapped in for the calling thread while executing
+
+  // Save states, see state::Header
+  uint16_t    mapper_num_ = {0};
+  uint32_t    crc_        = {0};
+  std::size_t state_size_ = {0};  // Every state of the cartridge is this big
+
+  void writeState(state::Writer* out) const;
+  void readState(state::Reader* in);
 };
 
+// Create a console specialised for MapperT, with the cartridge loaded. Returns nullptr if the cartridge can't be loaded
+template <class MapperT>
+console::Console* make(rom::Rom* rom, bool allow_unofficial_opcodes) {
+  Console<MapperT>* console = new Console<MapperT>(allow_unofficial_opcodes);
+  if (console->loadCart(rom)) {
+    delete console;
+    return nullptr;
+  }
+  return console;
+}
+
+}  // namespace internal
+
 }  // namespace hw::console
@@ -1,13 +1,20 @@
 #pragma once
 
+#include <nesemu/hw/opcodes.h>
+#include <nesemu/hw/state.h>
 #include <nesemu/utils/reg_bit.h>
 
+#include <array>
+#include <cstddef>
 #include <cstdint>
-#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 
 // Forward declarations
 namespace hw::system_bus {
+template <class MapperT>
 class SystemBus;
 }
 
@@ -16,162 +23,59 @@ class SystemBus;
 // Little endian
 namespace hw::cpu {
 
-enum class Instruction : uint8_t {
-  ADC = 0x69,  // ADd with Carry
-  AND = 0x29,  // bitwise AND with accumulator
-  ASL = 0x0A,  // Arithmetic Shift Left
-  BIT = 0x28,  // test BITs
-
-  // Branch Instructions
-  BPL = 0x10,  // Branch on PLus
-  BMI = 0x30,  // Branch on MInus
-  BVC = 0x50,  // Branch on oVerflow Clear
-  BVS = 0x70,  // Branch on oVerflow Set
-  BCC = 0x90,  // Branch on Carry Clear
-  BCS = 0xB0,  // Branch on Carry Set
-  BNE = 0xD0,  // Branch on Not Equal
-  BEQ = 0xF0,  // Branch on EQual
-
-  BRK = 0x00,  // BReaK
-  CMP = 0xC9,  // CoMPare accumulator
-  CPX = 0xE0,  // ComPare X register                 ** Alternate opcode offsets
-  CPY = 0xC0,  // ComPare Y register                 ** Alternate opcode offsets
-  DEC = 0xCA,  // DECrement memory
-  EOR = 0x49,  // bitwise Exclusive OR
-
-  // Flag (Processor Status) Instructions
-  CLC = 0x18,  // CLear Carry
-  SEC = 0x38,  // SEt Carry
-  CLI = 0x58,  // CLear Interrupt
-  SEI = 0x78,  // SEt Interrupt
-  CLV = 0xB8,  // CLear oVerflow
-  CLD = 0xD8,  // CLear Decimal
-  SED = 0xF8,  // SEt Decimal
-
-  INC = 0xEA,  // INCrement memory
-  JMP = 0x4C,  // JuMP
-  JSR = 0x1C,  // Jump to SubRoutine
-  LDA = 0xA9,  // LoaD Accumulator
-  LDX = 0xA2,  // LoaD X register                    ** Alternate opcode offsets
-  LDY = 0xA0,  // LoaD Y register                    ** Alternate opcode offsets
-  LSR = 0x4A,  // Logical Shift Right
-  NOP = 0xEA,  // No OPeration
-  ORA = 0x09,  // bitwise OR with Accumulator
-
-  // Register Instructions
-  TAX = 0xAA,  // Transfer A to X
-  TXA = 0x8A,  // Transfer X to A
-  DEX = 0xCA,  // DEcrement X
-  INX = 0xE8,  // INcrement X
-  TAY = 0xA8,  // Transfer A to Y
-  TYA = 0x98,  // Transfer Y to A
-  DEY = 0x88,  // DEcrement Y
-  INY = 0xC8,  // INcrement Y
-
-  ROL = 0x2A,  // ROtate Left
-  ROR = 0x6A,  // ROtate Right
-  RTI = 0x40,  // ReTurn from Interrupt
-  RTS = 0x60,  // ReTurn from Subroutine
-  SBC = 0xE9,  // SuBtract with Carry
-  STA = 0x89,  // STore Accumulator
-
-  // Stack Instructions
-  TXS = 0x9A,  // Transfer X to Stack ptr
-  TSX = 0xBA,  // Transfer Stack ptr to X
-  PHA = 0x48,  // PusH Accumulator
-  PLA = 0x68,  // PuLl Accumulator
-  PHP = 0x08,  // PusH Processor status
-  PLP = 0x28,  // PuLl Processor status
-
-  STX = 0x8A,  // STore X register
-  STY = 0x88,  // STore Y register
+// How the CPU runs code
+enum class Backend {
+  INTERPRETER,  // One instruction at a time
+  BLOCKS        // Basic blocks of PRG ROM at a time. Less overhead, but the console can only stop between blocks
 };
 
-enum class UnofficialInstruction : uint8_t {
-  // Combined operations
-  ALR   = 0x4B,
-  ANC_1 = 0x0B,
-  ANC_2 = 0x2B,
-  ARR   = 0x6B,
-  LAX   = 0xAB,
-  SAX   = 0x8B,
-
-  // Read-Modify-Write instructions
-  DCP = 0xCB,
-  ISC = 0xEB,
-  RLA = 0x2B,
-  RRA = 0x6B,
-  SLO = 0x0B,
-  SRE = 0x4B,
-
-  // Duplicate instructions
-  SBC = 0xEB,
-
-  // NOPs
-  NOP_1 = 0x1A,
-  NOP_2 = 0x3A,
-  NOP_3 = 0x5A,
-  NOP_4 = 0x7A,
-  NOP_5 = 0xDA,
-  NOP_6 = 0xFA,
-
-  SKB_1 = 0x80,
-  SKB_2 = 0x82,
-  SKB_3 = 0x89,
-  SKB_4 = 0xC2,
-  SKB_5 = 0xE2,
-
-  IGN_1 = 0x08,
-  IGN_2 = 0x28,
-  IGN_3 = 0x48,
-  IGN_4 = 0x68,
-  IGN_5 = 0xC8,
-  IGN_6 = 0xE8,
+// Programmer-visible state, ie. for comparing two CPUs
+struct Registers {
+  uint16_t pc;  // Program counter
+  uint8_t  sp;  // Stack pointer
+  uint8_t  a;   // Accumulator
+  uint8_t  x;   // Index register X
+  uint8_t  y;   // Index register Y
+  uint8_t  p;   // Processor status
+
+  bool operator==(const Registers& other) const {
+    return pc == other.pc && sp == other.sp && a == other.a && x == other.x && y == other.y && p == other.p;
+  }
+  bool operator!=(const Registers& other) const { return !(*this == other); }
 };
 
-
-enum class AddressingMode : int8_t {
-  implied     = 0x00,
-  accumulator = 0x00,
-  immediate   = 0x00,
-  relative    = 0x00,
-  zero_page   = -0x04,
-  zero_page_x = 0x0C,
-  zero_page_y = 0x0D,  // Incorrect val, should be 0x0C
-  absolute    = 0x04,
-  absolute_x  = 0x14,
-  absolute_y  = 0x10,
-  indirect    = 0x20,
-  indirect_x  = -0x08,
-  indirect_y  = 0x08,
-
-  // Alternates, used for CPX, CPY, LDX, LDY
-  alt_zero_page   = 0x04,
-  alt_zero_page_x = 0x14,
-  alt_zero_page_y = 0x14,
-  alt_absolute    = 0x0C,
-  alt_absolute_x  = 0x1C,
-  alt_absolute_y  = 0x1C,
-};
-
-
+// Specialised on the cartridge's mapper class, see system_bus::SystemBus
+template <class MapperT>
 class CPU {
 public:
 
   // Setup
   void allowUnofficialOpcodes(bool allow);
-  void connectBus(system_bus::SystemBus* bus);
+  void skipIdleLoops(bool skip);  // Fast-forward through loops which are only waiting for an interrupt or VBlank
+  void connectBus(system_bus::SystemBus<MapperT>* bus);
+  void loadCart(const uint8_t* prg_rom, std::size_t prg_size);
 
 
   // Execution
   void executeInstruction();
+  void executeBlock();  // Execute to the end of the current basic block, or a single instruction if not in PRG ROM
   void reset(bool active);
 
+  // Save states. Only between instructions
+  void saveState(state::Writer* out) const;
+  void loadState(state::Reader* in);
+
+  // Misc
+  Registers registers() const { return {PC, SP, A, X, Y, P.raw}; }
+  uint64_t  skippedCycles() const { return skipped_cycles_; }  // CPU cycles fast-forwarded through idle loops
+
 private:
-  bool allow_unofficial_ = {false};
+  bool     allow_unofficial_ = {false};
+  bool     skip_idle_loops_  = {false};
+  uint16_t next_op_          = {0};  // DEBUG builds step through instructions until reaching this address
 
   // System bus
-  system_bus::SystemBus* bus_ = {nullptr};
+  system_bus::SystemBus<MapperT>* bus_ = {nullptr};
 
   // Registers
   uint16_t PC = {0};          // Program counter
@@ -203,18 +107,77 @@ private:
   bool do_irq_[2]          = {false, false};
   bool reset_ready_        = {false};
 
+  // Opcode dispatch. Each opcode has its own handler, specialised on its operation and addressing mode, so executing
+  // an instruction is a single indirect call. Indexed by [allow_unofficial_][opcode]
+  using Handler = void (CPU::*)(uint16_t opcode_addr, uint8_t opcode);
+  static const std::array<Handler, 256> HANDLERS[2];
+
+  template <bool AllowUnofficial, std::size_t... Codes>
+  static constexpr std::array<Handler, 256> makeHandlers(std::index_sequence<Codes...>);
+  template <bool AllowUnofficial, std::size_t Code>
+  static constexpr Handler makeHandler();
+
+  template <Operation Op, AddressingMode Mode>
+  void execute(uint16_t opcode_addr, uint8_t opcode);
+  void illegal(uint16_t opcode_addr, uint8_t opcode);
+
+  // Decoded instruction cache, one entry per byte of PRG ROM. ROM never changes, so entries are found by their offset
+  // into PRG ROM rather than their CPU address, and stay valid across bank switches. Code in RAM is never cached
+  struct Decoded {
+    Handler handler  = {nullptr};  // Null until decoded
+    uint8_t bytes[3] = {0};        // Opcode and operands
+  };
+
+  const uint8_t*       prg_rom_  = {nullptr};
+  std::vector<Decoded> decoded_  = {};
+  const uint8_t*       operands_ = {nullptr};  // Remaining bytes of the decoded instruction being executed, if any
+
+  const Decoded* decode(uint16_t address);  // Returns nullptr if the instruction can't be cached
+
+  // Translated basic blocks, keyed by the offset of their first instruction in decoded_. A block runs up to the first
+  // instruction which can change the control flow, and never leaves its 8KiB bank
+  struct Block {
+    std::vector<const Decoded*> instructions = {};
+    bool                        idle         = {false};  // Loops back to its own start, see findIdleLoop
+    bool                        reads_status = {false};  // Idle, and polls PPUSTATUS
+  };
+  std::unordered_map<std::size_t, Block> blocks_ = {};
+
+  const Block* translate(uint16_t address);  // Returns nullptr if there's no block at the address
+  static constexpr bool endsBlock(Operation op);
+
+  // Idle loops. A short loop which only reads memory that nothing but the CPU can change does the same thing every
+  // iteration, until an interrupt arrives. Once one iteration has run and left the registers unchanged, the iterations
+  // before each of the bus's events are skipped at once. The one the event lands in is replayed an instruction at a
+  // time, so interrupts are still serviced after the right instruction
+  static constexpr std::size_t MAX_IDLE_LOOP_LENGTH = 8;      // Instructions
+  static constexpr uint64_t    MAX_IDLE_SKIP        = 29781;  // CPU cycles per call, a frame, so the console can stop
+  uint64_t                     skipped_cycles_      = {0};
+
+  static void findIdleLoop(Block* block, uint16_t address);
+  void        skipIdleLoop();  // Must only be called between instructions
+
   // Internal operations
+  inline void    executeDecoded(const Decoded* decoded);     // Execute a decoded instruction from PRG ROM
+  inline void    setRegisters(const Registers& registers);   // Restore the registers, ie. from registers()
+  inline uint8_t fetch();                                    // 1 cycle, read the byte at PC++
   inline uint8_t readByte(uint16_t address);                 // 1 cycle
   inline void    writeByte(uint16_t address, uint8_t data);  // 1 cycle
   inline void    push(uint8_t data);                         // 1 cycle
   inline uint8_t pop();                                      // 1 cycle
 
   inline void     tick(int ticks = 1);
+  inline bool     hasInterrupt() const;  // An interrupt is pending, and will be serviced before the next instruction
   inline void     pollInterrupt();
   inline void     interrupt();             // 5 cycles
   inline void     branch(bool condition);  // 1 cycle
-  inline uint16_t getArgAddr(std::underlying_type_t<AddressingMode> mode, bool check_page_boundary = false);
-  inline uint16_t getArgAddr(AddressingMode mode, bool check_page_boundary = false);
+
+  // Fetch the operand and compute its address. If dummy_read_optional, the dummy read for indexed modes is only done
+  // when a page boundary is crossed
+  template <AddressingMode Mode, bool dummy_read_optional = false>
+  inline uint16_t getArgAddr();
+  template <AddressingMode Mode, bool dummy_read_optional = false>
+  inline uint8_t readArg();  // Read the operand, either immediate or from getArgAddr()
 };
 
 }  // namespace hw::cpu
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t
+
+
+// Interfaces through which the emulated hardware talks to the outside world. The core never depends on a particular
+// frontend; a frontend (SDL, headless benchmark, test harness, etc) implements whichever of these it needs and attaches
+// them to the console. Any of them may be left unattached.
+namespace hw::io {
+
+// Receives every completed frame from the PPU
+class VideoSink {
+public:
+  virtual ~VideoSink() = default;
+
+  // Called at the start of VBlank of every frame drawn (see ppu::PPU::setFrameSkip), with 256x240 pixels. Each is a
+  // color and emphasis bits rather than RGB, see palette::Palette for converting them
+  virtual void update(const uint16_t* pixels) = 0;
+};
+
+
+// Receives the raw APU output, one sample per CPU cycle
+class AudioSink {
+public:
+  virtual ~AudioSink() = default;
+
+  virtual void update(uint8_t* stream, size_t len) = 0;
+};
+
+
+// Provides the state of the standard controllers
+class InputSource {
+public:
+  virtual ~InputSource() = default;
+
+  // Return the buttons currently held on the controller in the given port (1 or 2). One bit per button, in the order
+  // they are strobed: A, B, SELECT, START, UP, DOWN, LEFT, RIGHT (bit 0 to 7)
+  virtual uint8_t poll(uint8_t port) = 0;
+};
+
+}  // namespace hw::io
@@ -1,21 +1,37 @@
 #pragma once
 
+#include <nesemu/hw/state.h>
 #include <nesemu/utils/reg_bit.h>
 
 #include <cstdint>
 
 
+// Forward declarations
+namespace hw::io {
+class InputSource;
+}
+
+
 namespace hw::joystick {
 
 class Joystick {
 public:
   Joystick(uint8_t port) : port_(port) {};
 
+  // Setup
+  void setInput(io::InputSource* input) { input_ = input; }
+
+  // Execution
   void    write(uint8_t data);
   uint8_t read();
 
+  // Save states
+  void saveState(state::Writer* out) const;
+  void loadState(state::Reader* in);
+
 private:
-  uint8_t port_;  // Controller port, 1 or 2 ($4016 or $4017)
+  uint8_t          port_;               // Controller port, 1 or 2 ($4016 or $4017)
+  io::InputSource* input_ = {nullptr};  // Source of button presses, or nullptr for no controller
 
   // Registers
   union {                            // Joystick, mapped to CPU 0x4016 or 0x4017 for Joy1 and Joy2, respectively (RW)
@@ -5,11 +5,10 @@
 
 namespace hw::mapper::internal {
 
-class Mapper000 : public Mapper {
+// The default bank layout: 16KiB or 32KiB of PRG ROM, and 8KiB of CHR ROM/RAM, all fixed
+class Mapper000 final : public Mapper {
 public:
   using Mapper::Mapper;  // "Inherit" constructor
-
-  uint32_t decodeCPUAddress(uint16_t addr) const override { return addr & (prg_banks_ > 1 ? 0x7FFF : 0x3FFF); };
 };
 
 }  // namespace hw::mapper::internal
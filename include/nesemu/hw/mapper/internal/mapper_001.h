@@ -29,50 +29,10 @@ namespace hw::mapper::internal {
 //      0x0000-0x0FFF: Switchable (chr_bank_0_)
 //      0x1000-0x1FFF: Switchable (chr_bank_2_)
 
-class Mapper001 : public Mapper {
+class Mapper001 final : public Mapper {
 public:
   using Mapper::Mapper;  // "Inherit" constructor
 
-  uint32_t decodeCPUAddress(uint16_t addr) const override {
-    switch (control_ & 0x0C) {
-      case (0x00):  // Mode 0
-      case (0x04):  // Mode 1
-        return (0x8000 * (prg_bank_ & 0xFE)) | (addr & 0x7FFF);
-
-      case (0x08):  // Mode 2
-        if (addr < 0xC000) {
-          return addr & 0x3FFF;
-        } else {
-          return (0x4000 * prg_bank_) | (addr & 0x3FFF);
-        }
-
-      case (0x0C):  // Mode 3
-        if (addr < 0xC000) {
-          return (0x4000 * prg_bank_) | (addr & 0x3FFF);
-        } else {
-          return (0x4000 * (prg_banks_ - 1)) | (addr & 0x3FFF);
-        }
-
-      default:
-        utils::unreachable();
-    }
-  };
-
-
-  uint32_t decodePPUAddress(uint16_t addr) const override {
-    addr &= 0x1FFF;
-
-    if (control_ & 0x10) {
-      if (addr < 0x1000) {
-        return (0x1000 * chr_bank_0_) | (addr & 0x0FFF);
-      } else {
-        return (0x1000 * chr_bank_1_) | (addr & 0x0FFF);
-      }
-    } else {
-      return (0x2000 * (chr_bank_0_ & 0xFE)) | (addr & 0x1FFF);
-    }
-  };
-
   void write(uint16_t addr, uint8_t data) override {
     // TODO: Ignore consecutive writes, caused by double-writes in RMW instructions
 
@@ -119,12 +79,61 @@ public:
       }
 
       shift_register_ = 0x10;
+      remap();
     } else {
       shift_register_ >>= 1;
       shift_register_ |= (data & 0x01) << 4;
     }
   };
 
+protected:
+  void saveRegisters(state::Writer* out) const override {
+    out->put(shift_register_);
+    out->put(control_);
+    out->put(chr_bank_0_);
+    out->put(chr_bank_1_);
+    out->put(prg_bank_);
+  }
+
+  void loadRegisters(state::Reader* in) override {
+    in->get(shift_register_);
+    in->get(control_);
+    in->get(chr_bank_0_);
+    in->get(chr_bank_1_);
+    in->get(prg_bank_);
+  }
+
+  void updateBanks() override {
+    const uint8_t prg_bank = prg_bank_ & 0x0F;  // Bit 4 is PRG RAM enable
+
+    switch (control_ & 0x0C) {
+      case (0x00):  // Mode 0
+      case (0x04):  // Mode 1
+        mapPRG32(prg_bank >> 1);
+        break;
+
+      case (0x08):  // Mode 2
+        mapPRG16(0, 0);
+        mapPRG16(1, prg_bank);
+        break;
+
+      case (0x0C):  // Mode 3
+        mapPRG16(0, prg_bank);
+        mapPRG16(1, prg_banks_ - 1);
+        break;
+
+      default:
+        utils::unreachable();
+    }
+
+    if (control_ & 0x10) {
+      mapCHR4(0, chr_bank_0_);
+      mapCHR4(1, chr_bank_1_);
+    } else {
+      mapCHR8(chr_bank_0_ >> 1);
+    }
+  }
+
 private:
   uint8_t shift_register_ = {0x10};
 
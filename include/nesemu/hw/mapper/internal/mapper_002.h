@@ -5,23 +5,29 @@
 
 namespace hw::mapper::internal {
 
-class Mapper002 : public Mapper {
+class Mapper002 final : public Mapper {
 public:
   using Mapper::Mapper;  // "Inherit" constructor
 
-  uint32_t decodeCPUAddress(uint16_t addr) const override {
-    uint8_t bank_num = 0;
+  void write(uint16_t /*addr*/, uint8_t data) override {
+    prg_bank_ = data;
+    remap();
+  };
 
-    if (addr < 0xC000) {          // 0x8000-0xBFFF
-      bank_num = prg_bank_;       //
-    } else {                      // 0xC000-0xFFFF
-      bank_num = prg_banks_ - 1;  //
-    }
+protected:
+  void saveRegisters(state::Writer* out) const override {
+    out->put(prg_bank_);
+  }
 
-    return (0x4000 * bank_num) | (addr & 0x3FFF);
-  };
+  void loadRegisters(state::Reader* in) override {
+    in->get(prg_bank_);
+  }
 
-  void write(uint16_t /*addr*/, uint8_t data) override { prg_bank_ = data; };
+  void updateBanks() override {
+    mapPRG16(0, prg_bank_);       // 0x8000-0xBFFF
+    mapPRG16(1, prg_banks_ - 1);  // 0xC000-0xFFFF
+    mapCHR8(0);
+  }
 
 private:
   uint8_t prg_bank_ = {0};
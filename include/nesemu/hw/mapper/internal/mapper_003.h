@@ -5,13 +5,29 @@
 
 namespace hw::mapper::internal {
 
-class Mapper003 : public Mapper {
+class Mapper003 final : public Mapper {
 public:
   using Mapper::Mapper;  // "Inherit" constructor
 
-  uint32_t decodePPUAddress(uint16_t addr) const override { return (0x2000 * (chr_bank_)) | (addr & 0x1FFF); };
-
-  void write(uint16_t /*addr*/, uint8_t data) override { chr_bank_ = data; };
+  void write(uint16_t /*addr*/, uint8_t data) override {
+    chr_bank_ = data;
+    remap();
+  };
+
+protected:
+  void saveRegisters(state::Writer* out) const override {
+    out->put(chr_bank_);
+  }
+
+  void loadRegisters(state::Reader* in) override {
+    in->get(chr_bank_);
+  }
+
+  void updateBanks() override {
+    mapPRG16(0, 0);
+    mapPRG16(1, 1);
+    mapCHR8(chr_bank_);
+  }
 
 private:
   uint8_t chr_bank_ = {0};
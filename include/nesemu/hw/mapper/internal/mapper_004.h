@@ -38,40 +38,13 @@ namespace hw::mapper::internal {
 //      0x1000-0x17FF: Switchable (R0)
 //      0x1800-0x1FFF: Switchable (R1)
 
-class Mapper004 : public Mapper {
+class Mapper004 final : public Mapper {
 public:
-  using Mapper::Mapper;  // "Inherit" constructor
-
-  uint32_t decodeCPUAddress(uint16_t addr) const override {
-    uint8_t bank_num = 0;
-
-    if (bank_select_ & 0x40) {
-      if (addr < 0xA000) {                // 0x8000-0x9FFF
-        bank_num = (prg_banks_ * 2) - 2;  //   -> (-2)
-      } else if (addr < 0xC000) {         // 0xA000-0xBFFF
-        bank_num = bank_values_[7];       //   -> R7
-      } else if (addr < 0xE000) {         // 0xC000-0xDFFF
-        bank_num = bank_values_[6];       //   -> R6
-      } else {                            // 0xE000-0xFFFF
-        bank_num = (prg_banks_ * 2) - 1;  //   -> (-1)
-      }
-    } else {
-      if (addr < 0xA000) {                // 0x8000-0x9FFF
-        bank_num = bank_values_[6];       //   -> R6
-      } else if (addr < 0xC000) {         // 0xA000-0xBFFF
-        bank_num = bank_values_[7];       //   -> R7
-      } else if (addr < 0xE000) {         // 0xC000-0xDFFF
-        bank_num = (prg_banks_ * 2) - 2;  //   -> (-2)
-      } else {                            // 0xE000-0xFFFF
-        bank_num = (prg_banks_ * 2) - 1;  //   -> (-1)
-      }
-    }
-
-    return (0x2000 * bank_num) | (addr & 0x1FFF);
+  explicit Mapper004(uint8_t prg_banks, uint8_t chr_banks, Mirroring mirror) : Mapper(prg_banks, chr_banks, mirror) {
+    snoops_ppu_ = true;
   }
 
-
-  uint32_t decodePPUAddress(uint16_t addr) const override {
+  void snoopPPUAddress(uint16_t addr) override {
 
     // Clock scanline counter on rising edge of A12, after being low for 2 (3?) M2s
     cur_a12_ = addr & 0x1000;
@@ -89,37 +62,6 @@ public:
         has_irq_ = true;
       }
     }
-
-    addr &= 0x1FFF;
-    if (bank_select_ & 0x80) {
-      if (addr < 0x0400) {                                   // 0x0000-0x03FF
-        return (0x400 * bank_values_[2]) | (addr & 0x03FF);  //   -> R2
-      } else if (addr < 0x0800) {                            // 0x0400-0x07FF
-        return (0x400 * bank_values_[3]) | (addr & 0x03FF);  //   -> R3
-      } else if (addr < 0x0C00) {                            // 0x0800-0x0BFF
-        return (0x400 * bank_values_[4]) | (addr & 0x03FF);  //   -> R4
-      } else if (addr < 0x1000) {                            // 0x0C00-0x0FFF
-        return (0x400 * bank_values_[5]) | (addr & 0x03FF);  //   -> R5
-      } else if (addr < 0x1800) {                            // 0x1000-0x17FF
-        return (0x400 * bank_values_[0]) | (addr & 0x07FF);  //   -> R0
-      } else {                                               // 0x1800-0x1FFF
-        return (0x400 * bank_values_[1]) | (addr & 0x07FF);  //   -> R1
-      }
-    } else {
-      if (addr < 0x0800) {                                   // 0x0000-0x07FF
-        return (0x400 * bank_values_[0]) | (addr & 0x07FF);  //   -> R0
-      } else if (addr < 0x1000) {                            // 0x0800-0x0FFF
-        return (0x400 * bank_values_[1]) | (addr & 0x07FF);  //   -> R1
-      } else if (addr < 0x1400) {                            // 0x1000-0x13FF
-        return (0x400 * bank_values_[2]) | (addr & 0x03FF);  //   -> R2
-      } else if (addr < 0x1800) {                            // 0x1400-0x17FF
-        return (0x400 * bank_values_[3]) | (addr & 0x03FF);  //   -> R3
-      } else if (addr < 0x1C00) {                            // 0x1800-0x1BFF
-        return (0x400 * bank_values_[4]) | (addr & 0x03FF);  //   -> R4
-      } else {                                               // 0x1C00-0x1FFF
-        return (0x400 * bank_values_[5]) | (addr & 0x03FF);  //   -> R5
-      }
-    }
   }
 
 
@@ -134,6 +76,7 @@ public:
                                           !!(data & 0x40),
                                           !!(data & 0x80));
         bank_select_ = data;
+        remap();
         break;
       case 0x8001: {  // 0x8001-0x9FFF, odd
         const uint8_t bank = bank_select_ & 0x07;
@@ -144,10 +87,12 @@ public:
         }
         bank_values_[bank] = data;
         logger::log<logger::DEBUG_MAPPER>("Set bank[%d] = $%02X\n", bank, data);
+        remap();
       } break;
       case 0xA000:  // 0xA000-0xBFFE, even
         if (mirroring_ != Mirroring::none) {
           mirroring_ = (data & 0x01) ? Mirroring::horizontal : Mirroring::vertical;
+          remap();
         }
         break;
       case 0xA001:  // 0xA001-0xBFFF, odd
@@ -178,16 +123,72 @@ public:
 
   void clock() override { low_count_ = cur_a12_ ? 0 : low_count_ + 1; }
 
+protected:
+  void saveRegisters(state::Writer* out) const override {
+    out->put(bank_select_);
+    out->put(bank_values_);
+    out->put(irq_latch_);
+    out->put(irq_reload_);
+    out->put(irq_enable_);
+    out->put(irq_counter_);
+    out->put(has_irq_);
+    out->put(cur_a12_);
+    out->put(low_count_);
+  }
+
+  void loadRegisters(state::Reader* in) override {
+    in->get(bank_select_);
+    in->get(bank_values_);
+    in->get(irq_latch_);
+    in->get(irq_reload_);
+    in->get(irq_enable_);
+    in->get(irq_counter_);
+    in->get(has_irq_);
+    in->get(cur_a12_);
+    in->get(low_count_);
+  }
+
+  void updateBanks() override {
+    const unsigned second_last = (prg_banks_ * 2) - 2;
+    if (bank_select_ & 0x40) {
+      mapPRG8(0, second_last);      // 0x8000-0x9FFF -> (-2)
+      mapPRG8(1, bank_values_[7]);  // 0xA000-0xBFFF -> R7
+      mapPRG8(2, bank_values_[6]);  // 0xC000-0xDFFF -> R6
+    } else {
+      mapPRG8(0, bank_values_[6]);  // 0x8000-0x9FFF -> R6
+      mapPRG8(1, bank_values_[7]);  // 0xA000-0xBFFF -> R7
+      mapPRG8(2, second_last);      // 0xC000-0xDFFF -> (-2)
+    }
+    mapPRG8(3, second_last + 1);  // 0xE000-0xFFFF -> (-1)
+
+    // R0 and R1 select 2KiB banks, but are specified in 1KiB units with the LSB ignored
+    if (bank_select_ & 0x80) {
+      mapCHR1(0, bank_values_[2]);       // 0x0000-0x03FF -> R2
+      mapCHR1(1, bank_values_[3]);       // 0x0400-0x07FF -> R3
+      mapCHR1(2, bank_values_[4]);       // 0x0800-0x0BFF -> R4
+      mapCHR1(3, bank_values_[5]);       // 0x0C00-0x0FFF -> R5
+      mapCHR2(2, bank_values_[0] >> 1);  // 0x1000-0x17FF -> R0
+      mapCHR2(3, bank_values_[1] >> 1);  // 0x1800-0x1FFF -> R1
+    } else {
+      mapCHR2(0, bank_values_[0] >> 1);  // 0x0000-0x07FF -> R0
+      mapCHR2(1, bank_values_[1] >> 1);  // 0x0800-0x0FFF -> R1
+      mapCHR1(4, bank_values_[2]);       // 0x1000-0x13FF -> R2
+      mapCHR1(5, bank_values_[3]);       // 0x1400-0x17FF -> R3
+      mapCHR1(6, bank_values_[4]);       // 0x1800-0x1BFF -> R4
+      mapCHR1(7, bank_values_[5]);       // 0x1C00-0x1FFF -> R5
+    }
+  }
+
 private:
-  uint8_t         bank_select_    = {0};      // 0x8000-0x9FFF, even
-  uint8_t         bank_values_[8] = {0};      // 0x8000-0x9FFF, odd
-  uint8_t         irq_latch_      = {0};      // 0xC000-0xDFFF, even
-  mutable bool    irq_reload_     = {false};  // 0xC000-0xDFFF, odd
-  bool            irq_enable_     = {false};  // 0xE000-0xFFFE. Even=Disable, Odd=Enable
-  mutable uint8_t irq_counter_    = {0};
-  mutable bool    has_irq_        = {false};
-  mutable bool    cur_a12_        = {false};
-  mutable uint8_t low_count_      = {0};
+  uint8_t bank_select_    = {0};      // 0x8000-0x9FFF, even
+  uint8_t bank_values_[8] = {0};      // 0x8000-0x9FFF, odd
+  uint8_t irq_latch_      = {0};      // 0xC000-0xDFFF, even
+  bool    irq_reload_     = {false};  // 0xC000-0xDFFF, odd
+  bool    irq_enable_     = {false};  // 0xE000-0xFFFE. Even=Disable, Odd=Enable
+  uint8_t irq_counter_    = {0};
+  bool    has_irq_        = {false};
+  bool    cur_a12_        = {false};
+  uint8_t low_count_      = {0};
 };
 
 }  // namespace hw::mapper::internal
@@ -12,28 +12,22 @@ namespace hw::mapper::internal {
 // CHR ROM/RAM:
 //      0x0000-0x1FFF: Unbanked, but 4K auto-switchable
 
-class Mapper163 : public Mapper {
+class Mapper163 final : public Mapper {
 public:
-  using Mapper::Mapper;  // "Inherit" constructor
-
-  uint32_t decodeCPUAddress(uint16_t addr) const override {
-    const uint8_t bank_num = bank_select_ | (bank_sel_low_ ? 0b00 : 0b11);
-    return (0x8000 * bank_num) | (addr & 0x7FFF);
+  explicit Mapper163(uint8_t prg_banks, uint8_t chr_banks, Mirroring mirror) : Mapper(prg_banks, chr_banks, mirror) {
+    snoops_ppu_ = true;
   }
 
-  uint32_t decodePPUAddress(uint16_t addr) const override {
+  void snoopPPUAddress(uint16_t addr) override {
     // Latch A9 on A13 rising edge
     const bool a13 = addr >> 13;
     if (!ppu_a13_latch_ && a13) {
       ppu_a9_latch_ = !!(addr >> 9);
+      if (chr_ram_switch_) {
+        remap();
+      }
     }
     ppu_a13_latch_ = a13;
-
-    if (chr_ram_switch_ && !a13) {
-      return (addr & 0x0FFF) | (ppu_a9_latch_ << 12);
-    } else {
-      return (addr & 0x1FFF);
-    }
   }
 
   void write(uint16_t addr, uint8_t data) override {
@@ -46,11 +40,13 @@ public:
         bank_select_    = (bank_select_ & 0xF0) | (data_swap & 0x0F);
         chr_ram_switch_ = data_swap & 0x80;
         logger::log<logger::DEBUG_MAPPER>("Set bank select: %d, CHR RAM swap: %d\n", bank_select_, chr_ram_switch_);
+        remap();
         break;
       case 0x5200:  // PRG Bank High
       case 0x5201:
         bank_select_ = (bank_select_ & 0x0F) | ((data_swap & 0x03) << 4);
         logger::log<logger::DEBUG_MAPPER>("Set bank select: %d\n", bank_select_);
+        remap();
         break;
       case 0x5100:  // Feedback Write (A=0)
         e_ = data_swap & 0x01;
@@ -70,6 +66,7 @@ public:
         swap_d0_d1_   = (data & 0x01);
         bank_sel_low_ = (data & 0x04);
         logger::log<logger::DEBUG_MAPPER>("Swap D0,D1: %d, No force bank 0b11: %d\n", swap_d0_d1_, bank_sel_low_);
+        remap();
         break;
       default:
         logger::log<logger::ERROR>("Attempted to write invalid mapper addr $%02X\n", addr);
@@ -84,14 +81,48 @@ public:
     }
   }
 
+protected:
+  void saveRegisters(state::Writer* out) const override {
+    out->put(bank_select_);
+    out->put(chr_ram_switch_);
+    out->put(swap_d0_d1_);
+    out->put(bank_sel_low_);
+    out->put(ppu_a13_latch_);
+    out->put(ppu_a9_latch_);
+    out->put(e_);
+    out->put(f_);
+  }
+
+  void loadRegisters(state::Reader* in) override {
+    in->get(bank_select_);
+    in->get(chr_ram_switch_);
+    in->get(swap_d0_d1_);
+    in->get(bank_sel_low_);
+    in->get(ppu_a13_latch_);
+    in->get(ppu_a9_latch_);
+    in->get(e_);
+    in->get(f_);
+  }
+
+  void updateBanks() override {
+    mapPRG32(bank_select_ | (bank_sel_low_ ? 0b00 : 0b11));
+
+    if (chr_ram_switch_) {
+      mapCHR4(0, ppu_a9_latch_);
+      mapCHR4(1, ppu_a9_latch_);
+    } else {
+      mapCHR8(0);
+    }
+  }
+
 private:
   uint8_t bank_select_    = {0};      // 0x5000 (lower 4bit) | 0x5200 (upper 2bit)
   bool    chr_ram_switch_ = {false};  // CHR A12=PPU A9
   bool    swap_d0_d1_     = {false};  // Swap D0 and D1 on writes to 0x5000-0x5200
   bool    bank_sel_low_   = {false};  // Override bank_select_[0..1] = 0b11
 
-  mutable bool ppu_a13_latch_ = {false};
-  mutable bool ppu_a9_latch_  = {false};
+  bool ppu_a13_latch_ = {false};
+  bool ppu_a9_latch_  = {false};
 
   bool e_ = {false};
   bool f_ = {false};
@@ -1,81 +1,152 @@
 #pragma once
 
-#include <nesemu/utils/compat.h>
+#include <nesemu/hw/state.h>
 
 #include <cstdint>
 
 
 namespace hw::mapper {
 
-constexpr unsigned PRG_ROM_OFFSET = 0x8000;
-constexpr unsigned CHR_ROM_OFFSET = 0x0000;
-
 enum class Mirroring { none, vertical, horizontal, single_lower, single_upper };
 
+// The mapper translates CPU and PPU addresses into cartridge memory through bank pointer tables. The tables are only
+// recomputed when a bank register changes (see remap()), so a fetch is a table lookup rather than a virtual call:
+//
+//   CPU 0x8000-0xFFFF: 4x 8KiB PRG ROM banks
+//   PPU 0x0000-0x1FFF: 8x 1KiB CHR ROM/RAM banks
+//   PPU 0x2000-0x2FFF: 4x 1KiB nametables in CIRAM (mirrored to 0x3EFF)
 class Mapper {
 public:
   explicit Mapper(uint8_t prg_banks, uint8_t chr_banks, Mirroring mirror)
       : prg_banks_(prg_banks), chr_banks_(chr_banks), mirroring_(mirror) {};
   virtual ~Mapper() = default;
 
-  virtual uint32_t decodeCPUAddress(uint16_t addr) const { return addr - PRG_ROM_OFFSET; }
+  // Setup
+  void connectMemory(uint8_t* prg_rom, uint8_t* chr_mem) {
+    prg_rom_ = prg_rom;
+    chr_mem_ = chr_mem;
+    remap();
+  }
 
-  virtual uint32_t decodePPUAddress(uint16_t addr) const {
-    // Cartridge VRAM/VROM
-    // 0x0000-0x1FFF
-    return (addr & 0x1FFF) - CHR_ROM_OFFSET;
+  void connectCIRAM(uint8_t* ciram) {
+    ciram_ = ciram;
+    remap();
   }
 
-  virtual uint32_t decodeCIRAMAddress(uint16_t addr) const {
-    // Nametables
-    // 0x2000-0x2FFF, mirrored to 0x3EFF
-    // Mapped to 0x0000-0x0FFF
-    if (addr < 0x3F00) {
-      addr &= 0x0FFF;
-      switch (mirroring_) {
-        case Mirroring::none:  // Four-screen VRAM layout
-          return addr;
-        case Mirroring::vertical:  // Vertical mirroring
-          return addr & ~0x0800;
-        case Mirroring::horizontal:  // Horizontal mirroring
-          return addr & ~0x0400;
-        case Mirroring::single_lower:  // Single-screen, lower tilemap
-          return addr & 0x03FF;
-        case Mirroring::single_upper:  // Single-screen, upper tilemap
-          return (addr & 0x03FF) | 0x0400;
-          // No default
-      }
-    }
 
-    // Palettes
-    // 0x3F00-0x3F1F, mirrored to 0x3FFF
-    // Mapped to 0x1F00-0x1F1F
-    else {
-
-      // Color #0 of each sprite palette mirrors the corresponding background palette
-      addr &= 0x1F;
-      switch (addr) {
-        case 0x10:
-        case 0x14:
-        case 0x18:
-        case 0x1C:
-          addr &= ~0x10;
-      }
-      return 0x1F00 | addr;
-    }
-    utils::unreachable();
-  }
+  // Address translation
+  uint8_t* prg(uint16_t addr) const { return prg_map_[(addr >> 13) & 0x03] + (addr & 0x1FFF); }
+  uint8_t* chr(uint16_t addr) const { return chr_map_[(addr >> 10) & 0x07] + (addr & 0x03FF); }
+  uint8_t* ciram(uint16_t addr) const { return ciram_map_[(addr >> 10) & 0x03] + (addr & 0x03FF); }
+
+  // Physical CHR memory, regardless of banking, ie. for caching decoded tiles by their offset into it
+  const uint8_t* chrMemory() const { return chr_mem_; }
+  uint8_t*       chrMemory() { return chr_mem_; }
+  uint32_t       chrSize() const { return chrBanks1K() * 0x0400; }
+  uint32_t       chrOffset(uint16_t addr) const { return static_cast<uint32_t>(chr(addr) - chr_mem_); }
+
+  // Only mappers which watch the PPU address bus (eg. for A12 scanline counting) need to see every PPU address, so the
+  // PPU checks this before making the virtual call
+  bool         snoopsPPU() const { return snoops_ppu_; }
+  virtual void snoopPPUAddress(uint16_t /*addr*/) {};
 
+
+  // Execution
+  // The bus only checks the IRQ after write(), and after the PPU runs, so it may only change then (see snoopsPPU)
   virtual bool hasIRQ() const { return false; }
   virtual void read(uint16_t /*addr*/, uint8_t& /*data*/) {};
   virtual void write(uint16_t /*addr*/, uint8_t /*data*/) {};
   virtual void clock() {};
 
 
+  // Save states. The bank registers and mirroring. CHR RAM is saved by the PPU, and PRG RAM by the bus
+  void saveState(state::Writer* out) const {
+    out->put(static_cast<uint8_t>(mirroring_));
+    saveRegisters(out);
+  }
+
+  void loadState(state::Reader* in) {
+    mirroring_ = static_cast<Mirroring>(in->get<uint8_t>());
+    loadRegisters(in);
+    remap();
+  }
+
+
 protected:
-  uint8_t   prg_banks_;  ///< Number of 16KiB PRG ROM banks
-  uint8_t   chr_banks_;  ///< Number of 8KiB CHR ROM/RAM banks
-  Mirroring mirroring_;  ///< Mirroring scheme
+  uint8_t   prg_banks_;             ///< Number of 16KiB PRG ROM banks
+  uint8_t   chr_banks_;             ///< Number of 8KiB CHR ROM/RAM banks
+  Mirroring mirroring_;             ///< Mirroring scheme
+  bool      snoops_ppu_ = {false};  ///< Whether snoopPPUAddress() should be called
+
+  // Recompute the bank pointer tables. Must be called after any change to the bank registers or mirroring
+  void remap() {
+    updateBanks();
+    mapNametables();
+  }
+
+  // Fill the PRG and CHR tables using the map*() helpers below. Defaults to a fixed 32KiB PRG (16KiB mirrored if there
+  // is only one bank) and 8KiB CHR
+  virtual void updateBanks() {
+    mapPRG16(0, 0);
+    mapPRG16(1, 1);
+    mapCHR8(0);
+  }
+
+  // Bank numbers wrap around the size of the ROM, as the unconnected upper bank lines would on a real cartridge
+  void mapPRG8(unsigned slot, unsigned bank) { prg_map_[slot] = prg_rom_ + 0x2000 * (bank % prgBanks8K()); }
+  void mapPRG16(unsigned slot, unsigned bank) {
+    mapPRG8(slot * 2, bank * 2);
+    mapPRG8(slot * 2 + 1, bank * 2 + 1);
+  }
+  void mapPRG32(unsigned bank) {
+    mapPRG16(0, bank * 2);
+    mapPRG16(1, bank * 2 + 1);
+  }
+
+  void mapCHR1(unsigned slot, unsigned bank) { chr_map_[slot] = chr_mem_ + 0x0400 * (bank % chrBanks1K()); }
+  void mapCHR2(unsigned slot, unsigned bank) {
+    mapCHR1(slot * 2, bank * 2);
+    mapCHR1(slot * 2 + 1, bank * 2 + 1);
+  }
+  void mapCHR4(unsigned slot, unsigned bank) {
+    mapCHR2(slot * 2, bank * 2);
+    mapCHR2(slot * 2 + 1, bank * 2 + 1);
+  }
+  void mapCHR8(unsigned bank) {
+    mapCHR4(0, bank * 2);
+    mapCHR4(1, bank * 2 + 1);
+  }
+
+  // Save and load the mapper's own registers, if it has any
+  virtual void saveRegisters(state::Writer* /*out*/) const {};
+  virtual void loadRegisters(state::Reader* /*in*/) {};
+
+
+private:
+  uint8_t* prg_rom_ = {nullptr};  // Program ROM
+  uint8_t* chr_mem_ = {nullptr};  // Character ROM/RAM
+  uint8_t* ciram_   = {nullptr};  // Nametable RAM, in the PPU
+
+  uint8_t* prg_map_[4]   = {nullptr};  // 8KiB banks, CPU 0x8000-0xFFFF
+  uint8_t* chr_map_[8]   = {nullptr};  // 1KiB banks, PPU 0x0000-0x1FFF
+  uint8_t* ciram_map_[4] = {nullptr};  // 1KiB nametables, PPU 0x2000-0x2FFF
+
+  // Number of banks available. A cartridge without CHR ROM has 8KiB of CHR RAM instead
+  unsigned prgBanks8K() const { return prg_banks_ ? prg_banks_ * 2u : 1u; }
+  unsigned chrBanks1K() const { return chr_banks_ ? chr_banks_ * 8u : 8u; }
+
+  void mapNametables() {
+    static constexpr uint8_t LAYOUTS[][4] = {
+        {0, 1, 2, 3},  // Mirroring::none,         Four-screen VRAM layout
+        {0, 1, 0, 1},  // Mirroring::vertical,     Vertical mirroring
+        {0, 0, 2, 2},  // Mirroring::horizontal,   Horizontal mirroring
+        {0, 0, 0, 0},  // Mirroring::single_lower, Single-screen, lower tilemap
+        {1, 1, 1, 1},  // Mirroring::single_upper, Single-screen, upper tilemap
+    };
+    for (unsigned i = 0; i < 4; i++) {
+      ciram_map_[i] = ciram_ + 0x0400 * LAYOUTS[static_cast<unsigned>(mirroring_)][i];
+    }
+  }
 };
 
 }  // namespace hw::mapper
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "internal/mapper_000.h"
+#include "internal/mapper_001.h"
+#include "internal/mapper_002.h"
+#include "internal/mapper_003.h"
+#include "internal/mapper_004.h"
+#include "internal/mapper_163.h"
+#include <nesemu/hw/mapper/mapper_base.h>
+
+
+// Expands X(MapperT) for every mapper the core is specialised for, and for the generic mapper::Mapper which calls
+// through the vtable. Used to explicitly instantiate the mapper-specialised components, in their source files
+#define NESEMU_FOR_EACH_MAPPER(X)    \
+  X(hw::mapper::Mapper)              \
+  X(hw::mapper::internal::Mapper000) \
+  X(hw::mapper::internal::Mapper001) \
+  X(hw::mapper::internal::Mapper002) \
+  X(hw::mapper::internal::Mapper003) \
+  X(hw::mapper::internal::Mapper004) \
+  X(hw::mapper::internal::Mapper163)
@@ -6,6 +6,7 @@
 #include "internal/mapper_003.h"
 #include "internal/mapper_004.h"
 #include "internal/mapper_163.h"
+#include <nesemu/hw/console.h>
 #include <nesemu/hw/mapper/mapper_base.h>
 #include <nesemu/logger.h>
 
@@ -25,26 +26,48 @@ Mapper* dummy(uint8_t /*prg_banks*/, uint8_t /*chr_banks*/, Mirroring /*mirror*/
   return nullptr;
 }
 
-using mapper_generator = Mapper* (*) (uint8_t, uint8_t, Mirroring);
+console::Console* dummyConsole(rom::Rom* /*rom*/, bool /*allow_unofficial_opcodes*/) {
+  return nullptr;
+}
+
+using mapper_generator  = Mapper* (*) (uint8_t, uint8_t, Mirroring);
+using console_generator = console::Console* (*) (rom::Rom*, bool);
+
+struct Generators {
+  mapper_generator  mapper;   // Creates the mapper
+  console_generator console;  // Creates a console specialised for the mapper
+};
+
+template <class T>
+constexpr Generators generators = {make<T>, console::internal::make<T>};
 
-std::map<uint8_t, mapper_generator> mappers = {
-    {0, internal::make<internal::Mapper000>},    // Mapper 000 - Nintendo NROM
-    {1, internal::make<internal::Mapper001>},    // Mapper 001 - Nintendo MMC1
-    {2, internal::make<internal::Mapper002>},    // Mapper 002 - Nintendo UxROM
-    {3, internal::make<internal::Mapper003>},    // Mapper 003 - Nintendo CNROM
-    {4, internal::make<internal::Mapper004>},    // Mapper 004 - Nintendo MMC3
-    {163, internal::make<internal::Mapper163>},  // Mapper 163 - Nánjīng FC-001
+std::map<uint8_t, Generators> mappers = {
+    {0, generators<Mapper000>},    // Mapper 000 - Nintendo NROM
+    {1, generators<Mapper001>},    // Mapper 001 - Nintendo MMC1
+    {2, generators<Mapper002>},    // Mapper 002 - Nintendo UxROM
+    {3, generators<Mapper003>},    // Mapper 003 - Nintendo CNROM
+    {4, generators<Mapper004>},    // Mapper 004 - Nintendo MMC3
+    {163, generators<Mapper163>},  // Mapper 163 - Nánjīng FC-001
 };
 
 }  // namespace internal
 
 internal::mapper_generator getMapper(uint8_t mapper_num) {
   if (internal::mappers.find(mapper_num) != internal::mappers.end()) {
-    return internal::mappers[mapper_num];
+    return internal::mappers[mapper_num].mapper;
   } else {
     logger::log<logger::ERROR>("Mapper #%d not supported!\n", mapper_num);
     return internal::dummy;
   }
 }
 
+internal::console_generator getConsole(uint8_t mapper_num) {
+  if (internal::mappers.find(mapper_num) != internal::mappers.end()) {
+    return internal::mappers[mapper_num].console;
+  } else {
+    logger::log<logger::ERROR>("Mapper #%d not supported!\n", mapper_num);
+    return internal::dummyConsole;
+  }
+}
+
 }  // namespace hw::mapper
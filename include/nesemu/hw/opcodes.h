@@ -0,0 +1,381 @@
+#pragma once
+
+#include <cstdint>
+
+
+// Ricoh RP2A03 (based on MOS6502) opcode table
+namespace hw::cpu {
+
+enum class Operation : uint8_t {
+  ADC,  // ADd with Carry
+  AND,  // bitwise AND with accumulator
+  ASL,  // Arithmetic Shift Left
+  BIT,  // test BITs
+
+  // Branch Instructions
+  BPL,  // Branch on PLus
+  BMI,  // Branch on MInus
+  BVC,  // Branch on oVerflow Clear
+  BVS,  // Branch on oVerflow Set
+  BCC,  // Branch on Carry Clear
+  BCS,  // Branch on Carry Set
+  BNE,  // Branch on Not Equal
+  BEQ,  // Branch on EQual
+
+  BRK,  // BReaK
+  CMP,  // CoMPare accumulator
+  CPX,  // ComPare X register
+  CPY,  // ComPare Y register
+  DEC,  // DECrement memory
+  EOR,  // bitwise Exclusive OR
+
+  // Flag (Processor Status) Instructions
+  CLC,  // CLear Carry
+  SEC,  // SEt Carry
+  CLI,  // CLear Interrupt
+  SEI,  // SEt Interrupt
+  CLV,  // CLear oVerflow
+  CLD,  // CLear Decimal
+  SED,  // SEt Decimal
+
+  INC,  // INCrement memory
+  JMP,  // JuMP
+  JSR,  // Jump to SubRoutine
+  LDA,  // LoaD Accumulator
+  LDX,  // LoaD X register
+  LDY,  // LoaD Y register
+  LSR,  // Logical Shift Right
+  NOP,  // No OPeration. The unofficial SKB and IGN opcodes are NOPs which read their operand
+  ORA,  // bitwise OR with Accumulator
+
+  // Register Instructions
+  TAX,  // Transfer A to X
+  TXA,  // Transfer X to A
+  DEX,  // DEcrement X
+  INX,  // INcrement X
+  TAY,  // Transfer A to Y
+  TYA,  // Transfer Y to A
+  DEY,  // DEcrement Y
+  INY,  // INcrement Y
+
+  ROL,  // ROtate Left
+  ROR,  // ROtate Right
+  RTI,  // ReTurn from Interrupt
+  RTS,  // ReTurn from Subroutine
+  SBC,  // SuBtract with Carry
+  STA,  // STore Accumulator
+
+  // Stack Instructions
+  TXS,  // Transfer X to Stack ptr
+  TSX,  // Transfer Stack ptr to X
+  PHA,  // PusH Accumulator
+  PLA,  // PuLl Accumulator
+  PHP,  // PusH Processor status
+  PLP,  // PuLl Processor status
+
+  STX,  // STore X register
+  STY,  // STore Y register
+
+  // Unofficial combined operations
+  ALR,  // AND #i then LSR A
+  ANC,  // AND #i then C <- N
+  ARR,  // AND #i then ROR A, but with different flags
+  LAX,  // LDA then TAX
+  SAX,  // Store A & X
+
+  // Unofficial Read-Modify-Write instructions
+  DCP,  // DEC then CMP
+  ISC,  // INC then SBC
+  RLA,  // ROL then AND
+  RRA,  // ROR then ADC
+  SLO,  // ASL then ORA
+  SRE,  // LSR then EOR
+
+  ILL,  // ILLegal instruction, not implemented
+};
+
+enum class AddressingMode : uint8_t {
+  implied,
+  accumulator,
+  immediate,
+  relative,
+  zero_page,
+  zero_page_x,
+  zero_page_y,
+  absolute,
+  absolute_x,
+  absolute_y,
+  indirect,
+  indirect_x,
+  indirect_y,
+};
+
+struct Opcode {
+  Operation      operation;
+  AddressingMode mode;
+  uint8_t        length;    // Bytes, including the opcode
+  uint8_t        cycles;    // Base cycle count, not including page crossings or taken branches
+  bool           official;  // Unofficial opcodes are only executed if allowed, see CPU::allowUnofficialOpcodes()
+};
+
+// Every opcode, indexed by its value. BRK is counted as 2 bytes, as it skips a padding byte
+inline constexpr Opcode OPCODES[256] = {
+    {Operation::BRK, AddressingMode::implied, 2, 7, true},       // $00
+    {Operation::ORA, AddressingMode::indirect_x, 2, 6, true},    // $01
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $02
+    {Operation::SLO, AddressingMode::indirect_x, 2, 8, false},   // $03
+    {Operation::NOP, AddressingMode::zero_page, 2, 3, false},    // $04
+    {Operation::ORA, AddressingMode::zero_page, 2, 3, true},     // $05
+    {Operation::ASL, AddressingMode::zero_page, 2, 5, true},     // $06
+    {Operation::SLO, AddressingMode::zero_page, 2, 5, false},    // $07
+    {Operation::PHP, AddressingMode::implied, 1, 3, true},       // $08
+    {Operation::ORA, AddressingMode::immediate, 2, 2, true},     // $09
+    {Operation::ASL, AddressingMode::accumulator, 1, 2, true},   // $0A
+    {Operation::ANC, AddressingMode::immediate, 2, 2, false},    // $0B
+    {Operation::NOP, AddressingMode::absolute, 3, 4, false},     // $0C
+    {Operation::ORA, AddressingMode::absolute, 3, 4, true},      // $0D
+    {Operation::ASL, AddressingMode::absolute, 3, 6, true},      // $0E
+    {Operation::SLO, AddressingMode::absolute, 3, 6, false},     // $0F
+    {Operation::BPL, AddressingMode::relative, 2, 2, true},      // $10
+    {Operation::ORA, AddressingMode::indirect_y, 2, 5, true},    // $11
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $12
+    {Operation::SLO, AddressingMode::indirect_y, 2, 8, false},   // $13
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $14
+    {Operation::ORA, AddressingMode::zero_page_x, 2, 4, true},   // $15
+    {Operation::ASL, AddressingMode::zero_page_x, 2, 6, true},   // $16
+    {Operation::SLO, AddressingMode::zero_page_x, 2, 6, false},  // $17
+    {Operation::CLC, AddressingMode::implied, 1, 2, true},       // $18
+    {Operation::ORA, AddressingMode::absolute_y, 3, 4, true},    // $19
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $1A
+    {Operation::SLO, AddressingMode::absolute_y, 3, 7, false},   // $1B
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $1C
+    {Operation::ORA, AddressingMode::absolute_x, 3, 4, true},    // $1D
+    {Operation::ASL, AddressingMode::absolute_x, 3, 7, true},    // $1E
+    {Operation::SLO, AddressingMode::absolute_x, 3, 7, false},   // $1F
+    {Operation::JSR, AddressingMode::absolute, 3, 6, true},      // $20
+    {Operation::AND, AddressingMode::indirect_x, 2, 6, true},    // $21
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $22
+    {Operation::RLA, AddressingMode::indirect_x, 2, 8, false},   // $23
+    {Operation::BIT, AddressingMode::zero_page, 2, 3, true},     // $24
+    {Operation::AND, AddressingMode::zero_page, 2, 3, true},     // $25
+    {Operation::ROL, AddressingMode::zero_page, 2, 5, true},     // $26
+    {Operation::RLA, AddressingMode::zero_page, 2, 5, false},    // $27
+    {Operation::PLP, AddressingMode::implied, 1, 4, true},       // $28
+    {Operation::AND, AddressingMode::immediate, 2, 2, true},     // $29
+    {Operation::ROL, AddressingMode::accumulator, 1, 2, true},   // $2A
+    {Operation::ANC, AddressingMode::immediate, 2, 2, false},    // $2B
+    {Operation::BIT, AddressingMode::absolute, 3, 4, true},      // $2C
+    {Operation::AND, AddressingMode::absolute, 3, 4, true},      // $2D
+    {Operation::ROL, AddressingMode::absolute, 3, 6, true},      // $2E
+    {Operation::RLA, AddressingMode::absolute, 3, 6, false},     // $2F
+    {Operation::BMI, AddressingMode::relative, 2, 2, true},      // $30
+    {Operation::AND, AddressingMode::indirect_y, 2, 5, true},    // $31
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $32
+    {Operation::RLA, AddressingMode::indirect_y, 2, 8, false},   // $33
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $34
+    {Operation::AND, AddressingMode::zero_page_x, 2, 4, true},   // $35
+    {Operation::ROL, AddressingMode::zero_page_x, 2, 6, true},   // $36
+    {Operation::RLA, AddressingMode::zero_page_x, 2, 6, false},  // $37
+    {Operation::SEC, AddressingMode::implied, 1, 2, true},       // $38
+    {Operation::AND, AddressingMode::absolute_y, 3, 4, true},    // $39
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $3A
+    {Operation::RLA, AddressingMode::absolute_y, 3, 7, false},   // $3B
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $3C
+    {Operation::AND, AddressingMode::absolute_x, 3, 4, true},    // $3D
+    {Operation::ROL, AddressingMode::absolute_x, 3, 7, true},    // $3E
+    {Operation::RLA, AddressingMode::absolute_x, 3, 7, false},   // $3F
+    {Operation::RTI, AddressingMode::implied, 1, 6, true},       // $40
+    {Operation::EOR, AddressingMode::indirect_x, 2, 6, true},    // $41
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $42
+    {Operation::SRE, AddressingMode::indirect_x, 2, 8, false},   // $43
+    {Operation::NOP, AddressingMode::zero_page, 2, 3, false},    // $44
+    {Operation::EOR, AddressingMode::zero_page, 2, 3, true},     // $45
+    {Operation::LSR, AddressingMode::zero_page, 2, 5, true},     // $46
+    {Operation::SRE, AddressingMode::zero_page, 2, 5, false},    // $47
+    {Operation::PHA, AddressingMode::implied, 1, 3, true},       // $48
+    {Operation::EOR, AddressingMode::immediate, 2, 2, true},     // $49
+    {Operation::LSR, AddressingMode::accumulator, 1, 2, true},   // $4A
+    {Operation::ALR, AddressingMode::immediate, 2, 2, false},    // $4B
+    {Operation::JMP, AddressingMode::absolute, 3, 3, true},      // $4C
+    {Operation::EOR, AddressingMode::absolute, 3, 4, true},      // $4D
+    {Operation::LSR, AddressingMode::absolute, 3, 6, true},      // $4E
+    {Operation::SRE, AddressingMode::absolute, 3, 6, false},     // $4F
+    {Operation::BVC, AddressingMode::relative, 2, 2, true},      // $50
+    {Operation::EOR, AddressingMode::indirect_y, 2, 5, true},    // $51
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $52
+    {Operation::SRE, AddressingMode::indirect_y, 2, 8, false},   // $53
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $54
+    {Operation::EOR, AddressingMode::zero_page_x, 2, 4, true},   // $55
+    {Operation::LSR, AddressingMode::zero_page_x, 2, 6, true},   // $56
+    {Operation::SRE, AddressingMode::zero_page_x, 2, 6, false},  // $57
+    {Operation::CLI, AddressingMode::implied, 1, 2, true},       // $58
+    {Operation::EOR, AddressingMode::absolute_y, 3, 4, true},    // $59
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $5A
+    {Operation::SRE, AddressingMode::absolute_y, 3, 7, false},   // $5B
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $5C
+    {Operation::EOR, AddressingMode::absolute_x, 3, 4, true},    // $5D
+    {Operation::LSR, AddressingMode::absolute_x, 3, 7, true},    // $5E
+    {Operation::SRE, AddressingMode::absolute_x, 3, 7, false},   // $5F
+    {Operation::RTS, AddressingMode::implied, 1, 6, true},       // $60
+    {Operation::ADC, AddressingMode::indirect_x, 2, 6, true},    // $61
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $62
+    {Operation::RRA, AddressingMode::indirect_x, 2, 8, false},   // $63
+    {Operation::NOP, AddressingMode::zero_page, 2, 3, false},    // $64
+    {Operation::ADC, AddressingMode::zero_page, 2, 3, true},     // $65
+    {Operation::ROR, AddressingMode::zero_page, 2, 5, true},     // $66
+    {Operation::RRA, AddressingMode::zero_page, 2, 5, false},    // $67
+    {Operation::PLA, AddressingMode::implied, 1, 4, true},       // $68
+    {Operation::ADC, AddressingMode::immediate, 2, 2, true},     // $69
+    {Operation::ROR, AddressingMode::accumulator, 1, 2, true},   // $6A
+    {Operation::ARR, AddressingMode::immediate, 2, 2, false},    // $6B
+    {Operation::JMP, AddressingMode::indirect, 3, 5, true},      // $6C
+    {Operation::ADC, AddressingMode::absolute, 3, 4, true},      // $6D
+    {Operation::ROR, AddressingMode::absolute, 3, 6, true},      // $6E
+    {Operation::RRA, AddressingMode::absolute, 3, 6, false},     // $6F
+    {Operation::BVS, AddressingMode::relative, 2, 2, true},      // $70
+    {Operation::ADC, AddressingMode::indirect_y, 2, 5, true},    // $71
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $72
+    {Operation::RRA, AddressingMode::indirect_y, 2, 8, false},   // $73
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $74
+    {Operation::ADC, AddressingMode::zero_page_x, 2, 4, true},   // $75
+    {Operation::ROR, AddressingMode::zero_page_x, 2, 6, true},   // $76
+    {Operation::RRA, AddressingMode::zero_page_x, 2, 6, false},  // $77
+    {Operation::SEI, AddressingMode::implied, 1, 2, true},       // $78
+    {Operation::ADC, AddressingMode::absolute_y, 3, 4, true},    // $79
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $7A
+    {Operation::RRA, AddressingMode::absolute_y, 3, 7, false},   // $7B
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $7C
+    {Operation::ADC, AddressingMode::absolute_x, 3, 4, true},    // $7D
+    {Operation::ROR, AddressingMode::absolute_x, 3, 7, true},    // $7E
+    {Operation::RRA, AddressingMode::absolute_x, 3, 7, false},   // $7F
+    {Operation::NOP, AddressingMode::immediate, 2, 2, false},    // $80
+    {Operation::STA, AddressingMode::indirect_x, 2, 6, true},    // $81
+    {Operation::NOP, AddressingMode::immediate, 2, 2, false},    // $82
+    {Operation::SAX, AddressingMode::indirect_x, 2, 6, false},   // $83
+    {Operation::STY, AddressingMode::zero_page, 2, 3, true},     // $84
+    {Operation::STA, AddressingMode::zero_page, 2, 3, true},     // $85
+    {Operation::STX, AddressingMode::zero_page, 2, 3, true},     // $86
+    {Operation::SAX, AddressingMode::zero_page, 2, 3, false},    // $87
+    {Operation::DEY, AddressingMode::implied, 1, 2, true},       // $88
+    {Operation::NOP, AddressingMode::immediate, 2, 2, false},    // $89
+    {Operation::TXA, AddressingMode::implied, 1, 2, true},       // $8A
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $8B
+    {Operation::STY, AddressingMode::absolute, 3, 4, true},      // $8C
+    {Operation::STA, AddressingMode::absolute, 3, 4, true},      // $8D
+    {Operation::STX, AddressingMode::absolute, 3, 4, true},      // $8E
+    {Operation::SAX, AddressingMode::absolute, 3, 4, false},     // $8F
+    {Operation::BCC, AddressingMode::relative, 2, 2, true},      // $90
+    {Operation::STA, AddressingMode::indirect_y, 2, 6, true},    // $91
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $92
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $93
+    {Operation::STY, AddressingMode::zero_page_x, 2, 4, true},   // $94
+    {Operation::STA, AddressingMode::zero_page_x, 2, 4, true},   // $95
+    {Operation::STX, AddressingMode::zero_page_y, 2, 4, true},   // $96
+    {Operation::SAX, AddressingMode::zero_page_y, 2, 4, false},  // $97
+    {Operation::TYA, AddressingMode::implied, 1, 2, true},       // $98
+    {Operation::STA, AddressingMode::absolute_y, 3, 5, true},    // $99
+    {Operation::TXS, AddressingMode::implied, 1, 2, true},       // $9A
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $9B
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $9C
+    {Operation::STA, AddressingMode::absolute_x, 3, 5, true},    // $9D
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $9E
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $9F
+    {Operation::LDY, AddressingMode::immediate, 2, 2, true},     // $A0
+    {Operation::LDA, AddressingMode::indirect_x, 2, 6, true},    // $A1
+    {Operation::LDX, AddressingMode::immediate, 2, 2, true},     // $A2
+    {Operation::LAX, AddressingMode::indirect_x, 2, 6, false},   // $A3
+    {Operation::LDY, AddressingMode::zero_page, 2, 3, true},     // $A4
+    {Operation::LDA, AddressingMode::zero_page, 2, 3, true},     // $A5
+    {Operation::LDX, AddressingMode::zero_page, 2, 3, true},     // $A6
+    {Operation::LAX, AddressingMode::zero_page, 2, 3, false},    // $A7
+    {Operation::TAY, AddressingMode::implied, 1, 2, true},       // $A8
+    {Operation::LDA, AddressingMode::immediate, 2, 2, true},     // $A9
+    {Operation::TAX, AddressingMode::implied, 1, 2, true},       // $AA
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $AB
+    {Operation::LDY, AddressingMode::absolute, 3, 4, true},      // $AC
+    {Operation::LDA, AddressingMode::absolute, 3, 4, true},      // $AD
+    {Operation::LDX, AddressingMode::absolute, 3, 4, true},      // $AE
+    {Operation::LAX, AddressingMode::absolute, 3, 4, false},     // $AF
+    {Operation::BCS, AddressingMode::relative, 2, 2, true},      // $B0
+    {Operation::LDA, AddressingMode::indirect_y, 2, 5, true},    // $B1
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $B2
+    {Operation::LAX, AddressingMode::indirect_y, 2, 5, false},   // $B3
+    {Operation::LDY, AddressingMode::zero_page_x, 2, 4, true},   // $B4
+    {Operation::LDA, AddressingMode::zero_page_x, 2, 4, true},   // $B5
+    {Operation::LDX, AddressingMode::zero_page_y, 2, 4, true},   // $B6
+    {Operation::LAX, AddressingMode::zero_page_y, 2, 4, false},  // $B7
+    {Operation::CLV, AddressingMode::implied, 1, 2, true},       // $B8
+    {Operation::LDA, AddressingMode::absolute_y, 3, 4, true},    // $B9
+    {Operation::TSX, AddressingMode::implied, 1, 2, true},       // $BA
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $BB
+    {Operation::LDY, AddressingMode::absolute_x, 3, 4, true},    // $BC
+    {Operation::LDA, AddressingMode::absolute_x, 3, 4, true},    // $BD
+    {Operation::LDX, AddressingMode::absolute_y, 3, 4, true},    // $BE
+    {Operation::LAX, AddressingMode::absolute_y, 3, 4, false},   // $BF
+    {Operation::CPY, AddressingMode::immediate, 2, 2, true},     // $C0
+    {Operation::CMP, AddressingMode::indirect_x, 2, 6, true},    // $C1
+    {Operation::NOP, AddressingMode::immediate, 2, 2, false},    // $C2
+    {Operation::DCP, AddressingMode::indirect_x, 2, 8, false},   // $C3
+    {Operation::CPY, AddressingMode::zero_page, 2, 3, true},     // $C4
+    {Operation::CMP, AddressingMode::zero_page, 2, 3, true},     // $C5
+    {Operation::DEC, AddressingMode::zero_page, 2, 5, true},     // $C6
+    {Operation::DCP, AddressingMode::zero_page, 2, 5, false},    // $C7
+    {Operation::INY, AddressingMode::implied, 1, 2, true},       // $C8
+    {Operation::CMP, AddressingMode::immediate, 2, 2, true},     // $C9
+    {Operation::DEX, AddressingMode::implied, 1, 2, true},       // $CA
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $CB
+    {Operation::CPY, AddressingMode::absolute, 3, 4, true},      // $CC
+    {Operation::CMP, AddressingMode::absolute, 3, 4, true},      // $CD
+    {Operation::DEC, AddressingMode::absolute, 3, 6, true},      // $CE
+    {Operation::DCP, AddressingMode::absolute, 3, 6, false},     // $CF
+    {Operation::BNE, AddressingMode::relative, 2, 2, true},      // $D0
+    {Operation::CMP, AddressingMode::indirect_y, 2, 5, true},    // $D1
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $D2
+    {Operation::DCP, AddressingMode::indirect_y, 2, 8, false},   // $D3
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $D4
+    {Operation::CMP, AddressingMode::zero_page_x, 2, 4, true},   // $D5
+    {Operation::DEC, AddressingMode::zero_page_x, 2, 6, true},   // $D6
+    {Operation::DCP, AddressingMode::zero_page_x, 2, 6, false},  // $D7
+    {Operation::CLD, AddressingMode::implied, 1, 2, true},       // $D8
+    {Operation::CMP, AddressingMode::absolute_y, 3, 4, true},    // $D9
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $DA
+    {Operation::DCP, AddressingMode::absolute_y, 3, 7, false},   // $DB
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $DC
+    {Operation::CMP, AddressingMode::absolute_x, 3, 4, true},    // $DD
+    {Operation::DEC, AddressingMode::absolute_x, 3, 7, true},    // $DE
+    {Operation::DCP, AddressingMode::absolute_x, 3, 7, false},   // $DF
+    {Operation::CPX, AddressingMode::immediate, 2, 2, true},     // $E0
+    {Operation::SBC, AddressingMode::indirect_x, 2, 6, true},    // $E1
+    {Operation::NOP, AddressingMode::immediate, 2, 2, false},    // $E2
+    {Operation::ISC, AddressingMode::indirect_x, 2, 8, false},   // $E3
+    {Operation::CPX, AddressingMode::zero_page, 2, 3, true},     // $E4
+    {Operation::SBC, AddressingMode::zero_page, 2, 3, true},     // $E5
+    {Operation::INC, AddressingMode::zero_page, 2, 5, true},     // $E6
+    {Operation::ISC, AddressingMode::zero_page, 2, 5, false},    // $E7
+    {Operation::INX, AddressingMode::implied, 1, 2, true},       // $E8
+    {Operation::SBC, AddressingMode::immediate, 2, 2, true},     // $E9
+    {Operation::NOP, AddressingMode::implied, 1, 2, true},       // $EA
+    {Operation::SBC, AddressingMode::immediate, 2, 2, false},    // $EB
+    {Operation::CPX, AddressingMode::absolute, 3, 4, true},      // $EC
+    {Operation::SBC, AddressingMode::absolute, 3, 4, true},      // $ED
+    {Operation::INC, AddressingMode::absolute, 3, 6, true},      // $EE
+    {Operation::ISC, AddressingMode::absolute, 3, 6, false},     // $EF
+    {Operation::BEQ, AddressingMode::relative, 2, 2, true},      // $F0
+    {Operation::SBC, AddressingMode::indirect_y, 2, 5, true},    // $F1
+    {Operation::ILL, AddressingMode::implied, 1, 2, false},      // $F2
+    {Operation::ISC, AddressingMode::indirect_y, 2, 8, false},   // $F3
+    {Operation::NOP, AddressingMode::zero_page_x, 2, 4, false},  // $F4
+    {Operation::SBC, AddressingMode::zero_page_x, 2, 4, true},   // $F5
+    {Operation::INC, AddressingMode::zero_page_x, 2, 6, true},   // $F6
+    {Operation::ISC, AddressingMode::zero_page_x, 2, 6, false},  // $F7
+    {Operation::SED, AddressingMode::implied, 1, 2, true},       // $F8
+    {Operation::SBC, AddressingMode::absolute_y, 3, 4, true},    // $F9
+    {Operation::NOP, AddressingMode::implied, 1, 2, false},      // $FA
+    {Operation::ISC, AddressingMode::absolute_y, 3, 7, false},   // $FB
+    {Operation::NOP, AddressingMode::absolute_x, 3, 4, false},   // $FC
+    {Operation::SBC, AddressingMode::absolute_x, 3, 4, true},    // $FD
+    {Operation::INC, AddressingMode::absolute_x, 3, 7, true},    // $FE
+    {Operation::ISC, AddressingMode::absolute_x, 3, 7, false},   // $FF
+};
+
+}  // namespace hw::cpu
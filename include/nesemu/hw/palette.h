@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+namespace hw::palette {
+
+// The PPU outputs a 9 bit value per pixel, rather than a color. It is converted to ARGB8888 by a Palette, if at all
+// 876543210
+// |||||||||
+// |||++++++- Color, from palette RAM
+// ||+------- Emphasize red   (PPUMASK bit 5)
+// |+-------- Emphasize green (PPUMASK bit 6)
+// +--------- Emphasize blue  (PPUMASK bit 7)
+constexpr std::size_t NUM_ENTRIES = 512;
+
+// Frames are converted a whole frame at a time, optionally scaled up by repeating each pixel (nearest neighbour)
+constexpr unsigned WIDTH     = 256;
+constexpr unsigned HEIGHT    = 240;
+constexpr unsigned MAX_SCALE = 4;
+
+// How a frame is converted. By default, the fastest kernel the CPU supports is picked at runtime
+enum class Kernel {
+  SCALAR,  // Plain C++, works everywhere
+  SSE2,    // x86 only. Scalar lookups, vector stores
+  AVX2     // x86 only. Gathered lookups, vector stores
+};
+
+class Palette {
+public:
+  Palette();  // The built-in palette
+
+  // Load a .pal file of RGB triplets: either 64 colors, whose emphasized variants are derived the same way as for the
+  // built-in palette, or all 512 entries. Returns 0 on success, and leaves the palette unchanged on failure
+  int loadFromFile(const std::string& filename);
+
+  uint32_t operator[](uint16_t pixel) const { return colors_[pixel & (NUM_ENTRIES - 1)]; }
+
+  // Convert a WIDTH x HEIGHT frame, scaled up by 1 to MAX_SCALE. argb must hold (WIDTH * scale) x (HEIGHT * scale)
+  // pixels. Returns 0 on success
+  int convert(const uint16_t* pixels, uint32_t* argb, unsigned scale = 1) const;
+
+  // Kernel selection. setKernel() returns 0 on success, or leaves the kernel unchanged if the CPU doesn't support it
+  int           setKernel(Kernel kernel);
+  Kernel        kernel() const { return kernel_; }
+  static bool   supports(Kernel kernel);
+  static Kernel bestKernel();
+
+private:
+  uint32_t colors_[NUM_ENTRIES] = {0};
+  Kernel   kernel_              = {Kernel::SCALAR};
+
+  void emphasize();  // Derive entries 64-511 from the first 64
+};
+
+}  // namespace hw::palette
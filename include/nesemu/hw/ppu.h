@@ -1,13 +1,19 @@
 #pragma once
 
+#include <nesemu/hw/state.h>
 #include <nesemu/utils/compat.h>
 #include <nesemu/utils/reg_bit.h>
 
 #include <cstdint>
 #include <cstring>  //memcpy
+#include <vector>
 
 
 // Forward declarations
+namespace hw::io {
+class VideoSink;
+}
+
 namespace hw::mapper {
 class Mapper;
 }
@@ -15,7 +21,6 @@ class Mapper;
 namespace ui {
 class NametableViewer;
 class PatternTableViewer;
-class Screen;
 class SpriteViewer;
 }  // namespace ui
 
@@ -36,6 +41,30 @@ enum class MemoryMappedIO {
   OAMDMA    = 0x4014
 };
 
+// How the PPU draws visible scanlines
+enum class Renderer {
+  DOTS,      // One dot at a time
+  SCANLINES  // A whole scanline at a time, whenever nothing can change mid-line. Otherwise one dot at a time
+};
+
+// State visible to the CPU, ie. for comparing two PPUs
+struct Registers {
+  uint16_t v;         // Current VRAM address
+  uint16_t t;         // Temporary VRAM address
+  uint8_t  fine_x;    // Fine X scroll
+  uint8_t  status;    // PPUSTATUS
+  uint16_t scanline;  // Current dot
+  uint16_t cycle;     //
+
+  bool operator==(const Registers& other) const {
+    return v == other.v && t == other.t && fine_x == other.fine_x && status == other.status
+           && scanline == other.scanline && cycle == other.cycle;
+  }
+  bool operator!=(const Registers& other) const { return !(*this == other); }
+};
+
+// The PPU state, and everything which doesn't depend on the cartridge's mapper. The rendering itself is in
+// internal::PPU, which is specialised on the mapper class
 class PPU {
   friend class ui::NametableViewer;
   friend class ui::PatternTableViewer;
@@ -43,21 +72,40 @@ class PPU {
 
 public:
   // Setup
-  void loadCart(mapper::Mapper* mapper, uint8_t* chr_mem, bool is_ram);
-  void setScreen(ui::Screen* screen);
+  void setScreen(io::VideoSink* screen);
+  void setRenderer(Renderer renderer) { renderer_ = renderer; }
+  void setFrameSkip(uint32_t ratio) { frame_skip_ = ratio; }  // Draw every ratio-th frame. 0 = only when requested
+  void renderNextFrame() { render_next_frame_ = true; }       // Draw the next frame to start, whatever the skip ratio
 
 
   // Execution
-  void    clock();
-  bool    hasNMI();
-  uint8_t readRegister(uint16_t cpu_address);
-  void    writeRegister(uint16_t cpu_address, uint8_t data);
-  void    spriteDMAWrite(uint8_t* data);  // CPU 0x4014. Load sprite memory with 256 bytes.
+  bool hasNMI();
+  void spriteDMAWrite(const uint8_t* data);  // CPU 0x4014. Load sprite memory with 256 bytes.
 
+  // Misc
+  uint64_t frameCount() const { return frame_count_; }  // Number of frames completed, ie. post-render lines reached
+  uint32_t statusStableDots() const;                    // Dots for which reading PPUSTATUS can't change anything
+  uint32_t dotsUntilEvent() const;                      // Dots to clock until the CPU could see a change, eg. NMI
+  Registers registers() const;
 
-private:
+  // Save states. The screen buffer isn't saved, so a state loaded mid-frame shows the previous frame above the current
+  // dot until the next frame
+  void saveState(state::Writer* out) const;
+  void loadState(state::Reader* in);
+
+
+protected:
   // Other chips
-  ui::Screen* screen_ = {nullptr};
+  io::VideoSink* screen_ = {nullptr};
+
+  Renderer renderer_ = {Renderer::SCANLINES};
+
+  // Frame skipping. Skipped frames are still emulated in full, so that everything the CPU can see (sprite zero hit,
+  // overflow, VBlank, the scroll registers, and the address bus the mapper watches) is the same. Only the pixels aren't
+  // looked up or stored, and the screen isn't given the frame
+  uint32_t frame_skip_        = {1};
+  bool     render_next_frame_ = {false};
+  bool     draw_frame_        = {true};  // Whether the current frame is drawn
 
 
   // Registers
@@ -181,7 +229,7 @@ private:
 
   // Sprite evaluation state machine
   struct SpriteEvaluationFSM {
-    enum class State { CHECK_Y_IN_RANGE, COPY_SPRITE, OVERFLOW, DUMMY_READ, DONE } state_;
+    enum class State { CHECK_Y_IN_RANGE, COPY_SPRITE, OVERFLOW, DUMMY_READ, DONE } state_ = {State::CHECK_Y_IN_RANGE};
     uint8_t state_counter_ = {0};  // Number of cycles until state change
     uint8_t poam_index_    = {0};  // Position within primary OAM (0-64)*4
     uint8_t soam_index_    = {0};  // Position within secondary OAM (0-8)*4
@@ -193,10 +241,9 @@ private:
   // Background registers
   PPUReg   t_ = {0};
   PPUReg   v_ = {0};
-  uint8_t  fine_x_scroll_ : 3;        // X offset of the scanline within a tile
+  uint8_t  fine_x_scroll_   = {0};    // 3-bit. X offset of the scanline within a tile
   bool     write_toggle_    = false;  // 0 indicates first write
-  uint16_t pattern_sr_a_    = {0};    // Lower byte of pattern, controls bit 0 of the color
-  uint16_t pattern_sr_b_    = {0};    // Upper byte of pattern, controls bit 1 of the color
+  uint32_t pattern_sr_      = {0};    // Pattern of 2 tiles, 2 bits per pixel, see ChrRow
   uint8_t  palette_sr_a_    = {0};    // Palette number, controls bit 2 of the color
   uint8_t  palette_sr_b_    = {0};    // Palette number, controls bit 3 of the color
   bool     palette_latch_a_ = {false};
@@ -211,51 +258,120 @@ private:
   union {
     uint8_t byte[0x40];
     Sprite  sprite[0x08];
-  } secondary_oam_                          = {0};      // 64 byte/8 sprite ram, for current scanline
-  uint8_t          num_sprites_fetched_     = {0};      // The number of sprites fetched so far
-  bool             oam_has_sprite_zero_     = {false};  // Whether the secondary OAM contains sprite 0 (next line)
-  bool             sr_has_sprite_zero_      = {false};  // Whether the sprite registers contains sprite 0 (current line)
-  bool             did_hit_sprite_zero_     = {false};  // Whether sprite zero hit has occurred this frame
-  uint8_t          sprite_pattern_sr_a_[8]  = {0};      // Lower byte of pattern, controls bit 0 of the color
-  uint8_t          sprite_pattern_sr_b_[8]  = {0};      // Upper byte of pattern, controls bit 1 of the color
-  SpriteAttributes sprite_palette_latch_[8] = {};       //
-  uint8_t          sprite_x_position_[8]    = {0};      //
+  } secondary_oam_ = {0};  // 64 byte/8 sprite ram, for current scanline
+  uint8_t num_sprites_fetched_ = {0};      // The number of sprites fetched so far
+  bool    oam_has_sprite_zero_ = {false};  // Whether the secondary OAM contains sprite 0 (next line)
+  bool    sr_has_sprite_zero_  = {false};  // Whether the sprite line contains sprite 0 (current line)
+  bool    did_hit_sprite_zero_ = {false};  // Whether sprite zero hit has occurred this frame
+
+  // Sprite pixels of the current line, one per dot. The sprites are drawn into it as they are fetched during the
+  // previous line, so that each dot only has to look up its pixel. Only the front-most opaque sprite is kept, which is
+  // also the one the hardware picks (even if it's behind the background, and a later sprite isn't)
+  union SpritePixel {
+    uint8_t             raw;
+    utils::RegBit<0, 2> pixel;        // Pixel value from pattern data. 0 if transparent
+    utils::RegBit<2, 2> palette;      // Palette (4 to 7) of sprite
+    utils::RegBit<4, 1> priority;     // 0=In front of background, 1=Behind background
+    utils::RegBit<5, 1> sprite_zero;  // From the first sprite in the secondary OAM
+  };
+  SpritePixel sprite_line_[256] = {};
 
 
   // Memory-mapped IO Registers
-  uint8_t   io_latch_ = {0};  //
-  CtrlReg1  ctrl_reg_1_;      // PPU Control Register 1, mapped to CPU 0x2000 (RW)
-  CtrlReg2  ctrl_reg_2_;      // PPU Control Register 2, mapped to CPU 0x2001 (RW)
-  StatusReg status_reg_;      // PPU Status Register, mapped to CPU 0x2002 (R)
-  uint8_t   oam_addr_ = {0};  // Object Attribute Memory Address, mapped to CPU 0x2003 (W)
+  uint8_t   io_latch_    = {0};  //
+  CtrlReg1  ctrl_reg_1_  = {};   // PPU Control Register 1, mapped to CPU 0x2000 (RW)
+  CtrlReg2  ctrl_reg_2_  = {};   // PPU Control Register 2, mapped to CPU 0x2001 (RW)
+  StatusReg status_reg_  = {};   // PPU Status Register, mapped to CPU 0x2002 (R)
+  uint8_t   oam_addr_    = {0};  // Object Attribute Memory Address, mapped to CPU 0x2003 (W)
+  uint8_t   read_buffer_ = {0};  // PPUDATA read buffer, returned by the next read of CPU 0x2007
 
   uint8_t vblank_suppression_counter_ = {0};
 
 
   // Memory
-  mapper::Mapper* mapper_         = {nullptr};
+  mapper::Mapper* mapper_         = {nullptr};  // Maps character VRAM/VROM and nametables, at address 0x0000-0x2FFF
   uint8_t         ram_[0x2000]    = {0};        // 8KiB RAM, at address 0x2000-0x3FFF
-  uint8_t*        chr_mem_        = {nullptr};  // Character VRAM/VROM, at address 0x0000-0x1FFF
-  bool            chr_mem_is_ram_ = {false};    // Whether chr_mem is VRAM or VROM
+  bool            chr_mem_is_ram_ = {false};    // Whether the cartridge has character VRAM or VROM
+
+  // Rows of CHR tiles, decoded to 2 bits per pixel with the leftmost pixel in the top bits, so that a row is fetched
+  // with one lookup instead of two bitplane reads. Indexed by the row's offset into the physical CHR memory (see
+  // chrRowIndex), so the cache stays valid across bank switches. CHR RAM writes decode the row again
+  struct ChrRow {
+    uint16_t pixels;   // Left to right
+    uint16_t flipped;  // Right to left, for horizontally flipped sprites
+  };
+  std::vector<ChrRow> chr_rows_ = {};
+
+  static uint32_t chrRowIndex(uint32_t offset) { return ((offset >> 4) << 3) | (offset & 0x07); }
+  void            decodeChrRow(uint32_t offset);   // Offset of either bitplane byte of the row
+  const ChrRow&   chrRow(uint16_t address) const;  // Without letting the mapper see it, for debugging
 
 
   // Rendering
-  uint32_t pixels_[256 * 240] = {0};  // Screen buffer
+  uint16_t pixels_[256 * 240] = {0};  // Screen buffer, see palette::Palette
   uint16_t scanline_          = {0};  // 0 to 262
   uint16_t cycle_             = {1};  // 0 to 341
   bool     frame_is_odd_      = true;
+  uint64_t frame_count_       = {0};
 
 
   // Internal operations
-  uint8_t readByte(uint16_t address) const;
-  void    writeByte(uint16_t address, uint8_t data);
-  void    renderPixel();
+  uint8_t  peekByte(uint16_t address) const;                    // Read without letting the mapper see it, for debugging
+  uint32_t dotsUntil(uint16_t scanline, uint16_t cycle) const;  // Dots to clock before reaching a dot. May undercount
+  uint16_t pixelColor(uint8_t palette_addr) const;              // Output of a palette entry, see palette::Palette
+
+  // Palettes, 0x3F00-0x3F1F, mirrored to 0x3FFF. Mapped to RAM 0x1F00-0x1F1F
+  // Color #0 of each sprite palette mirrors the corresponding background palette
+  static inline uint16_t paletteAddress(uint16_t address) {
+    address &= 0x1F;
+    if ((address & 0x13) == 0x10) {
+      address &= ~0x10;
+    }
+    return 0x1F00 | address;
+  }
+};
+
 
+namespace internal {
+
+// Specialised on the cartridge's mapper class, see system_bus::SystemBus
+template <class MapperT>
+class PPU : public ppu::PPU {
+public:
+  // Setup
+  void loadCart(MapperT* mapper, bool is_ram);
+
+
+  // Execution
+  void    run(uint32_t dots);  // Clock the PPU this many times
+  uint8_t readRegister(uint16_t cpu_address);
+  void    writeRegister(uint16_t cpu_address, uint8_t data);
+
+
+private:
+  MapperT* mapper() const { return static_cast<MapperT*>(mapper_); }
+
+  // Internal operations
+  inline void    clock();
+  inline void    renderScanline();  // Run a whole visible line, see Renderer::SCANLINES
+  uint8_t        readByte(uint16_t address) const;
+  void           writeByte(uint16_t address, uint8_t data);
+  void           renderPixel();
+  inline uint8_t nextPixel(uint16_t x);  // Shift out the pixel at x. Returns its palette address
+  inline void    skipTile();             // Shift out 8 pixels without looking at them, on skipped frames
+
+  inline void snoopAddress(uint16_t address) const;  // Let the mapper see the address bus, if it needs to
   inline void fetchTilesAndSprites(bool fetch_sprites);
+  inline void evaluateSprite();    // One step of the sprite evaluation state machine, on even dots 66-256
+  inline void startSpriteFetch();  // Dot 257
+  inline void fetchFirstBGTile();  // Dot 328
   inline void fetchNextBGTile();
   inline void fetchNextSprite();
+  inline const ChrRow& fetchChrRow(uint16_t address) const;  // Both bitplanes of a pattern table row
   inline void incrementCoarseX();
   inline void incrementFineY();
 };
 
+}  // namespace internal
+
 }  // namespace hw::ppu
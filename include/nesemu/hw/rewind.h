@@ -0,0 +1,81 @@
+#pragma once
+
+#include <nesemu/hw/io.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+
+// Forward declarations
+namespace hw::console {
+class Console;
+}
+
+
+// Rewinding. Keeps the most recent frames' snapshots (see console::Console::snapshot) in a fixed amount of memory,
+// dropping the oldest to make room. Every keyframe_interval-th frame is kept whole, as a keyframe. The frames between
+// are kept as deltas: the frame XORed with the one before, which is mostly zeros, run-length encoded. Each frame also
+// keeps the input it was run with, so it can be run again exactly
+namespace hw::rewind {
+
+class Rewind : public io::InputSource {
+public:
+  Rewind(std::size_t budget, unsigned keyframe_interval);  // Budget in bytes, of stored frames
+
+  // Store the console's current state as the newest frame, ie. after every console::Console::runFrame()
+  void capture(console::Console* console);
+
+  // Drop the newest frame, and load the one before it into the console. Returns non-zero if there is no frame before
+  int stepBack(console::Console* console);
+
+  // Load the frame age frames before the newest into the console, dropping nothing. Returns non-zero if it was dropped
+  int load(console::Console* console, std::size_t age);
+
+  // Run the newest frame again from the one before, with the input it was run with, then load it exactly. The console's
+  // sinks see the frame again, which loading the state alone can't give them (eg. the picture). The console must take
+  // its input from this. Returns non-zero if there is no frame before
+  int replay(console::Console* console);
+
+  // Input. Attached to the console in front of the frontend's input source, to remember what each frame was run with.
+  // Input is taken to be the same for a whole frame, as frontends only update it between frames
+  void    setInput(io::InputSource* input) { input_ = input; }
+  uint8_t poll(uint8_t port) override;
+
+  void clear();
+
+  std::size_t frames() const { return frames_.size(); }
+  std::size_t keyframes() const;
+  std::size_t bytesUsed() const;  // Of the budget, not including the gap left when wrapping around
+
+private:
+  struct Frame {
+    std::size_t offset;    // Into buffer_
+    std::size_t size;      // Bytes
+    unsigned    position;  // Frames since the last keyframe, so 0 for a keyframe
+    uint8_t     input[2];  // Buttons held on each controller, see io::InputSource
+  };
+
+  std::vector<uint8_t> buffer_;  // Ring of encoded frames, oldest first. A frame which doesn't fit before the end
+                                 // starts again at the beginning
+  std::size_t          head_              = {0};  // Where the next frame goes
+  unsigned             keyframe_interval_ = {1};
+  std::deque<Frame>    frames_;  // Oldest first, always starting with a keyframe
+
+  std::vector<uint8_t> newest_;   // Snapshot of the newest frame, decoded
+  std::vector<uint8_t> scratch_;  // Snapshot being captured, or frame being loaded
+  std::vector<uint8_t> delta_;    // Delta being encoded
+
+  io::InputSource* input_      = {nullptr};
+  uint8_t          buttons_[2] = {0};  // Of the frame being run, or replayed
+  bool             replaying_  = {false};
+
+  uint8_t* reserve(std::size_t size);  // Drop the oldest keyframe and its deltas until there's room for a new frame
+  void     decode(std::size_t index, std::vector<uint8_t>* state) const;  // Rebuild the frame at frames_[index]
+
+  static std::size_t encode(const uint8_t* state, const uint8_t* previous, std::size_t size, uint8_t* delta);
+  static void        apply(const uint8_t* delta, std::size_t delta_size, uint8_t* state);
+};
+
+}  // namespace hw::rewind
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <nesemu/utils/enum.h>
+
+#include <algorithm>  // std::min
+#include <cstddef>
+#include <cstdint>
+
+
+namespace hw::scheduler {
+
+// Chips which run behind the CPU, and only catch up when the CPU could see a change in them
+enum class Event {
+  PPU,  // See ppu::PPU::dotsUntilEvent
+  APU,  // See apu::APU::cyclesUntilEvent
+  COUNT
+};
+
+// When each chip next has to catch up, as an absolute CPU cycle count. The earliest is kept at hand, so checking
+// whether anything is due costs a single comparison per cycle
+class Scheduler {
+public:
+  static constexpr uint64_t NEVER = UINT64_MAX;
+
+  void schedule(Event event, uint64_t cycle) {
+    uint64_t&      slot     = cycles_[utils::asInt(event)];
+    const uint64_t previous = slot;
+    slot                    = cycle;
+
+    if (cycle <= next_) {
+      next_ = cycle;
+    } else if (previous == next_) {  // The earliest event moved later, so find the new earliest
+      next_ = NEVER;
+      for (const uint64_t c : cycles_) {
+        next_ = std::min(next_, c);
+      }
+    }
+  }
+
+  uint64_t next() const { return next_; }  // Cycle of the earliest event
+  bool     due(Event event, uint64_t now) const { return cycles_[utils::asInt(event)] <= now; }
+
+private:
+  static constexpr std::size_t COUNT = utils::asInt(Event::COUNT);
+
+  uint64_t cycles_[COUNT] = {0};  // Everything catches up on the first cycle
+  uint64_t next_          = {0};
+};
+
+}  // namespace hw::scheduler
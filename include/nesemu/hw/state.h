@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // memcpy
+#include <type_traits>
+
+
+// Save states
+//
+// A state is each chip's fields, one after another in a fixed order, each copied as it is laid out in memory (so in the
+// host's byte order). Nothing is tagged or padded, so a state is only as big as the fields, and every state of a given
+// cartridge is the same size. Derived data (decoded tile and instruction caches, bank pointers, the schedule) is
+// rebuilt when a state is loaded. See console::Console::saveState for the header
+namespace hw::state {
+
+constexpr uint32_t MAGIC   = 0x5353454E;  // "NESS"
+constexpr uint16_t VERSION = 2;           // Must be bumped whenever any chip's fields change
+
+struct Header {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t mapper;  // Mapper number
+  uint32_t crc;     // Of the ROM, see rom::Rom
+  uint32_t size;    // Of the whole state, including this header
+};
+static_assert(sizeof(Header) == 16, "No padding");
+
+// Writes into a buffer which must be big enough, see size(). With no buffer, only counts the bytes, ie. to size one
+class Writer {
+public:
+  explicit Writer(uint8_t* data) : data_(data) {}
+
+  template <class T>
+  void put(const T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Fields must be plain data");
+    putBytes(&value, sizeof(T));
+  }
+
+  void putBytes(const void* src, std::size_t size) {
+    if (data_) {
+      memcpy(data_ + size_, src, size);
+    }
+    size_ += size;
+  }
+
+  std::size_t size() const { return size_; }  // Bytes written so far
+
+private:
+  uint8_t*    data_;
+  std::size_t size_ = {0};
+};
+
+// Reading past the end fails the reader rather than the read, so chips don't have to check every field. The caller
+// checks failed() once everything has been read
+class Reader {
+public:
+  Reader(const uint8_t* data, std::size_t size) : data_(data), size_(size) {}
+
+  template <class T>
+  void get(T& value) {
+    static_assert(std::is_trivially_copyable_v<T>, "Fields must be plain data");
+    getBytes(&value, sizeof(T));
+  }
+
+  template <class T>
+  T get() {
+    T value = {};
+    get(value);
+    return value;
+  }
+
+  void getBytes(void* dst, std::size_t size) {
+    if (const uint8_t* src = view(size)) {
+      memcpy(dst, src, size);
+    }
+  }
+
+  // The next bytes, without copying them. Returns nullptr if there aren't enough left
+  const uint8_t* view(std::size_t size) {
+    if (size > size_ - offset_) {
+      failed_ = true;
+      offset_ = size_;
+      return nullptr;
+    }
+    const uint8_t* src = data_ + offset_;
+    offset_ += size;
+    return src;
+  }
+
+  bool        failed() const { return failed_; }
+  std::size_t remaining() const { return size_ - offset_; }
+
+private:
+  const uint8_t* data_;
+  std::size_t    size_;
+  std::size_t    offset_ = {0};
+  bool           failed_ = {false};
+};
+
+}  // namespace hw::state
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <nesemu/hw/scheduler.h>
+#include <nesemu/hw/state.h>
+#include <nesemu/logger.h>
+
 #include <cstdint>
 
 
@@ -13,10 +17,12 @@ class CPUClock;
 }
 
 namespace hw::cpu {
+template <class MapperT>
 class CPU;
 }
 
-namespace hw::ppu {
+namespace hw::ppu::internal {
+template <class MapperT>
 class PPU;
 }
 
@@ -33,45 +39,163 @@ namespace hw::system_bus {
 
 /**
  * Represents the CPU address space, interrupt lines, and clock lines
+ *
+ * Specialised on the cartridge's mapper class, so that calls to it can be inlined. MapperT=mapper::Mapper goes through
+ * the vtable instead, and works for any mapper
  */
+template <class MapperT>
 class SystemBus {
 public:
   // Setup
-  void connectChips(clock::CPUClock*    clock,
-                    apu::APU*           apu,
-                    cpu::CPU*           cpu,
-                    ppu::PPU*           ppu,
-                    joystick::Joystick* joy_1,
-                    joystick::Joystick* joy_2);
-  void loadCart(mapper::Mapper* mapper, uint8_t* prg_rom, uint8_t* expansion_ram);
+  void connectChips(clock::CPUClock*             clock,
+                    apu::APU*                    apu,
+                    cpu::CPU<MapperT>*           cpu,
+                    ppu::internal::PPU<MapperT>* ppu,
+                    joystick::Joystick*          joy_1,
+                    joystick::Joystick*          joy_2);
+  void loadCart(MapperT* mapper, uint8_t* expansion_ram);
 
 
   // Execution
-  bool    hasIRQ() const;
-  bool    hasNMI() const;
-  uint8_t read(uint16_t address) const;
-  void    write(uint16_t address, uint8_t data);
-  void    clock();
+  bool     hasIRQ() const { return lines_ & IRQ_LINES; }
+  bool     hasNMI() const { return lines_ & NMI_PPU; }
+  void     clock();
+  uint32_t statusStableCycles() const;  // CPU cycles for which reading PPUSTATUS can't change anything
+  void     sync();                      // Catch the other chips up to the CPU, ie. before handing control to the UI
+
+  uint8_t read(uint16_t address) const {
+    const ReadPage& page = read_map_[address >> 8];
+    open_bus_            = page.mem ? page.mem[address & 0xFF] : (this->*page.handler)(address);
+    logger::log<logger::DEBUG_BUS>("Read $%02X from $(%04X)\n", open_bus_, address);
+    return open_bus_;
+  }
+
+  // A read whose result the caller already knows, ie. from the CPU's decoded instruction cache. Only valid for plain
+  // memory, where it has the same effect as read()
+  uint8_t readKnown(uint16_t address, uint8_t data) const {
+    open_bus_ = data;
+    logger::log<logger::DEBUG_BUS>("Read $%02X from $(%04X)\n", open_bus_, address);
+    return open_bus_;
+  }
+
+  // Pointer to the byte at an address backed by plain memory, or nullptr for MMIO. Has no side effects
+  const uint8_t* peek(uint16_t address) const {
+    const uint8_t* mem = read_map_[address >> 8].mem;
+    return mem ? mem + (address & 0xFF) : nullptr;
+  }
+
+  void write(uint16_t address, uint8_t data) {
+    logger::log<logger::DEBUG_BUS>("Write $%02X to $(%04X)\n", data, address);
+    const WritePage& page = write_map_[address >> 8];
+    if (page.mem) {
+      page.mem[address & 0xFF] = data;
+    } else {
+      (this->*page.handler)(address, data);
+    }
+  }
+
+  // Misc
+  uint64_t cycles() const { return cycles_; }                 // Number of CPU cycles elapsed
+  uint64_t prgGeneration() const { return prg_generation_; }  // Changes whenever the PRG ROM banks may have switched
+
+  // Idle loops (see cpu::CPU::skipIdleLoop). Nothing but events can change what the CPU sees, so the cycles up to the
+  // next one can be skipped at once. Mappers which count CPU cycles (see mapper::Mapper::clock) watch the PPU bus, so
+  // the next event is always the next cycle
+  uint64_t cyclesUntilEvent() const { return scheduler_.next() > cycles_ ? scheduler_.next() - cycles_ : 0; }
+  void     skip(uint32_t cycles);  // Must stop short of the next event
+  uint8_t  openBus() const { return open_bus_; }
+  void     setOpenBus(uint8_t data) const { open_bus_ = data; }
 
   // DMC DMA
   bool hasDMCDMA() const;
   void doDMCDMA();
 
+  // Save states. Saving needs the other chips caught up (see sync()). Loading must come after every other chip, as it
+  // maps the PRG banks again and catches up, to rebuild the interrupt lines and the schedule
+  void saveState(state::Writer* out) const;
+  void loadState(state::Reader* in);
+
 private:
   // Memory
-  mapper::Mapper* mapper_        = {nullptr};
+  MapperT*        mapper_        = {nullptr};  // Maps program ROM,           at address 0x8000-0xFFFF
   uint8_t         ram_[0x800]    = {0};        // 2KiB RAM, mirrored 4 times, at address 0x0000-0x1FFF
   uint8_t*        expansion_ram_ = {nullptr};  // Optional cartridge RAM,     at address 0x7000-0x7FFF
-  uint8_t*        prg_rom_       = {nullptr};  // Unmapped program ROM,       at address 0x8000-0xFFFF
+  mutable uint8_t open_bus_      = {0};        // Last value read, returned when nothing drives the bus
+
+
+  // Memory map
+  // One entry per 256 byte page in each direction. Pages backed by plain memory (RAM, cartridge RAM, PRG ROM) point
+  // straight at it. Everything else (MMIO, mapper registers, open bus) has a null pointer and goes through the handler
+  using ReadHandler  = uint8_t (SystemBus::*)(uint16_t address) const;
+  using WriteHandler = void (SystemBus::*)(uint16_t address, uint8_t data);
+
+  struct ReadPage {
+    const uint8_t* mem;
+    ReadHandler    handler;
+  };
+
+  struct WritePage {
+    uint8_t*     mem;
+    WriteHandler handler;
+  };
+
+  ReadPage  read_map_[0x100]  = {};
+  WritePage write_map_[0x100] = {};
+
+  void mapMemory();
+  void mapPRG();  // Refresh the PRG ROM pages from the mapper. Must be called whenever it may have switched banks
+
+  uint8_t readOpenBus(uint16_t address) const;
+  uint8_t readPPU(uint16_t address) const;
+  uint8_t readIO(uint16_t address) const;  // APU and joysticks, 0x4000-0x40FF
+  uint8_t readMapper(uint16_t address) const;
+  uint8_t readNoCartRAM(uint16_t address) const;
+  void    writeNone(uint16_t address, uint8_t data);
+  void    writePPU(uint16_t address, uint8_t data);
+  void    writeAPU(uint16_t address, uint8_t data);
+  void    writeIO(uint16_t address, uint8_t data);  // APU, joysticks and OAM DMA, 0x4000-0x40FF
+  void    writeMapper(uint16_t address, uint8_t data);
+
+
+  // Clock
+  uint64_t cycles_         = {0};
+  uint64_t prg_generation_ = {0};
+
+  // The PPU and APU run behind the CPU, and only catch up when the CPU could see them: on register accesses, DMAs,
+  // mapper writes (which may switch CHR banks or mirroring), and their own events (see ppu::PPU::dotsUntilEvent and
+  // apu::APU::cyclesUntilEvent), which are kept in the scheduler. Mappers which watch the PPU address bus keep it in
+  // lockstep instead
+  mutable scheduler::Scheduler scheduler_;
+  mutable uint64_t             ppu_cycles_ = {0};  // CPU cycles the PPU has caught up to
+  mutable uint64_t             apu_cycles_ = {0};  // CPU cycles the APU has caught up to
+
+  static constexpr uint32_t MAX_APU_LAG = 114;  // CPU cycles. Catch the APU up once a scanline, to feed the speaker
+
+  void syncPPU() const;
+  void syncAPU() const;
+  void runEvents();
+
+
+  // Interrupt lines, one bit per source. A source's bit is updated whenever its output may have changed, ie. when it
+  // catches up or the CPU accesses it, so the CPU can poll them every cycle without asking each chip
+  enum Line : uint8_t {
+    NMI_PPU    = 0x01,
+    IRQ_APU    = 0x02,  // Frame counter and DMC
+    IRQ_MAPPER = 0x04,
+  };
+  static constexpr uint8_t IRQ_LINES = IRQ_APU | IRQ_MAPPER;
+  mutable uint8_t          lines_    = {0};
+
+  void setLine(Line line, bool active) const { lines_ = active ? (lines_ | line) : (lines_ & ~line); }
 
 
   // Chips
-  clock::CPUClock*    clock_;
-  apu::APU*           apu_;
-  cpu::CPU*           cpu_;
-  ppu::PPU*           ppu_;
-  joystick::Joystick* joy_1_;
-  joystick::Joystick* joy_2_;
+  clock::CPUClock*             clock_;
+  apu::APU*                    apu_;
+  cpu::CPU<MapperT>*           cpu_;
+  ppu::internal::PPU<MapperT>* ppu_;
+  joystick::Joystick*          joy_1_;
+  joystick::Joystick*          joy_2_;
 };
 
 }  // namespace hw::system_bus
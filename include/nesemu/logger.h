@@ -3,6 +3,17 @@
 #include <cstdio>
 
 
+// Levels compiled in, as a mask of logger::Level. Logging at any other level compiles to nothing, and can't be enabled
+// at runtime. The DEBUG_* levels are only compiled in when asked for, see DEBUG_LOGGING in CMakeLists.txt
+#ifndef NESEMU_LOG_MASK
+#if DEBUG
+#define NESEMU_LOG_MASK 0xFF
+#else
+#define NESEMU_LOG_MASK 0x07
+#endif
+#endif
+
+
 namespace logger {
 
 enum Level {
@@ -17,12 +28,47 @@ enum Level {
   DEBUG_MAPPER = 0x80,
 };
 
-extern Level level;
+constexpr Level COMPILED  = static_cast<Level>(NESEMU_LOG_MASK);
+constexpr Level DEBUG_ALL = static_cast<Level>(DEBUG_CPU | DEBUG_PPU | DEBUG_APU | DEBUG_BUS | DEBUG_MAPPER);
+
+// Levels logged by the calling thread. A console swaps in its own level while it runs (see Scope), so consoles can log
+// differently even when they share a thread
+inline thread_local Level level = static_cast<Level>(ERROR | WARNING | INFO);
+
+// Sets the calling thread's level until destroyed
+class Scope {
+public:
+  explicit Scope(Level scoped) : previous_(level) { level = scoped; }
+  ~Scope() { level = previous_; }
+
+  Scope(const Scope&)            = delete;
+  Scope& operator=(const Scope&) = delete;
+
+private:
+  Level previous_;
+};
+
+// Wait until the calling thread's queued messages have been written, ie. before writing to stdout directly
+void flush();
+
+namespace internal {
+void print(const char* format, ...);  // Write now, after anything this thread has queued
+void queue(const char* format, ...);  // Queue for the background writer. Dropped (and counted) if the queue is full
+}  // namespace internal
 
+// Errors, warnings and info are printed straight away, so are never lost and stay in order with the program's own
+// output. Debug messages can come from every bus access, so are only formatted on the calling thread, and written out
+// by a background thread
 template <Level L, typename... T>
 inline void log(const char* format, T... args) {
-  if (L & level) {
-    printf(format, args...);
+  if constexpr ((L & COMPILED) != 0) {
+    if (L & level) {
+      if constexpr ((L & DEBUG_ALL) != 0) {
+        internal::queue(format, args...);
+      } else {
+        internal::print(format, args...);
+      }
+    }
   }
 }
 
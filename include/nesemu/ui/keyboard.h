@@ -0,0 +1,19 @@
+#pragma once
+
+#include <nesemu/hw/io.h>
+
+#include <cstdint>
+
+
+namespace ui {
+
+// Maps the host keyboard onto the standard controllers
+class Keyboard : public hw::io::InputSource {
+public:
+  uint8_t poll(uint8_t port) override;
+
+private:
+  const uint8_t* state_ = {nullptr};
+};
+
+}  // namespace ui
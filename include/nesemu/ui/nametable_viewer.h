@@ -2,8 +2,15 @@
 
 #include <nesemu/ui/window.h>
 
+#include <cstdint>
+#include <vector>
+
 
 // Forward declarations
+namespace hw::palette {
+class Palette;
+}
+
 namespace hw::ppu {
 class PPU;
 }
@@ -15,11 +22,16 @@ class NametableViewer : public Window {
 public:
   NametableViewer() : Window(512, 480) {}
 
-  void attachPPU(const hw::ppu::PPU* ppu) { ppu_ = ppu; };
+  void attachPPU(const hw::ppu::PPU* ppu, const hw::palette::Palette* colors) {
+    ppu_    = ppu;
+    colors_ = colors;
+  };
   void update() override;
 
 private:
-  const hw::ppu::PPU* ppu_ = {nullptr};
+  const hw::ppu::PPU*         ppu_    = {nullptr};
+  const hw::palette::Palette* colors_ = {nullptr};  // Converts palette RAM to RGB
+  std::vector<uint32_t>       pixels_ = std::vector<uint32_t>(TEXTURE_WIDTH * TEXTURE_HEIGHT);
 };
 
 }  // namespace ui
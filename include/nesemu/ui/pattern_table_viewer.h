@@ -2,8 +2,15 @@
 
 #include <nesemu/ui/window.h>
 
+#include <cstdint>
+#include <vector>
+
 
 // Forward declarations
+namespace hw::palette {
+class Palette;
+}
+
 namespace hw::ppu {
 class PPU;
 }
@@ -16,13 +23,18 @@ public:
   // Two 16x16 tables of 8x8 tiles, stacked vertically
   PatternTableViewer() : Window(128, 256) {}
 
-  void attachPPU(const hw::ppu::PPU* ppu) { ppu_ = ppu; };
+  void attachPPU(const hw::ppu::PPU* ppu, const hw::palette::Palette* colors) {
+    ppu_    = ppu;
+    colors_ = colors;
+  };
   void update() override;
   void focus() override;
 
 private:
-  const hw::ppu::PPU* ppu_ = {nullptr};
-  uint8_t palette_ = {0};
+  const hw::ppu::PPU*         ppu_     = {nullptr};
+  const hw::palette::Palette* colors_  = {nullptr};  // Converts palette RAM to RGB
+  uint8_t                     palette_ = {0};
+  std::vector<uint32_t>       pixels_  = std::vector<uint32_t>(TEXTURE_WIDTH * TEXTURE_HEIGHT);
 };
 
 }  // namespace ui
@@ -1,34 +1,47 @@
-#pragma once
-
-#include <nesemu/ui/window.h>
-#include <nesemu/utils/buffer.h>
-
-#include <chrono>
-#include <cstdint>
-
-#include <SDL2/SDL.h>
-
-
-namespace ui {
-
-class Screen : public Window {
-public:
-  Screen() : Window(256, 240) {}
-
-  // Note: Do not use default update(), since this window is updated in the PPU loop rather than SDL loop
-  void update() override {};
-  void update(const uint32_t* pixels_);
-
-  void handleEvent(SDL_Event& event) override;
-
-
-private:
-  unsigned frame_ = {0};
-
-  utils::Buffer<double, 10>             fps_buffer_;
-  std::chrono::steady_clock::time_point prev_frame_;
-
-  bool lock_aspect_ratio_ = true;
-};
-
-}  // namespace ui
+#pragma once
+
+#include <nesemu/hw/io.h>
+#include <nesemu/hw/palette.h>
+#include <nesemu/ui/window.h>
+#include <nesemu/utils/buffer.h>
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+
+namespace ui {
+
+class Screen : public Window, public hw::io::VideoSink {
+public:
+  Screen() : Window(256, 240), rgb_(256 * 240 * hw::palette::MAX_SCALE * hw::palette::MAX_SCALE) {}
+
+  // Note: Do not use default update(), since this window is updated in the PPU loop rather than SDL loop
+  void update() override {};
+  void update(const uint16_t* pixels) override;
+
+  void setPalette(const hw::palette::Palette* colors) { colors_ = colors; }
+
+  void handleEvent(SDL_Event& event) override;
+
+
+private:
+  unsigned frame_ = {0};
+
+  // The frame is converted to RGB and scaled up by the largest whole factor which fits the window, so SDL only has to
+  // scale the remainder
+  const hw::palette::Palette* colors_ = {nullptr};  // Converts the PPU output to RGB
+  std::vector<uint32_t>       rgb_    = {};         // Sized for MAX_SCALE, see the constructor
+  unsigned                    scale_  = {1};        // Of the texture
+
+  unsigned fitScale() const;  // Largest scale which fits the window
+
+  utils::Buffer<double, 10>             fps_buffer_;
+  std::chrono::steady_clock::time_point prev_frame_;
+
+  bool lock_aspect_ratio_ = true;
+};
+
+}  // namespace ui
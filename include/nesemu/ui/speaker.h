@@ -1,59 +1,91 @@
-#pragma once
-
-#include <algorithm>  // std::min
-#include <cstddef>    // size_t
-#include <cstdint>    // uint8_t, uint16_t
-
-#include <SDL2/SDL.h>
-
-
-namespace ui {
-
-class Speaker;
-void audio_callback(Speaker* speaker, uint8_t* stream, size_t len);
-
-class Speaker {
-public:
-  bool init();
-  void close();
-  void update(uint8_t* stream, size_t len);
-  void setVolume(float volume) { volume_ = std::max(std::min(volume, 1.f), 0.f); };
-  void addVolume(float delta) { volume_ = std::max(std::min(volume_ + delta, 1.f), 0.f); };
-  void pause(bool pause);
-
-private:
-  friend void audio_callback(Speaker* speaker, uint8_t* stream, size_t len);
-
-  // We need to downsample from ~1.79MHz to a standard freq like 44.1kHz. Since the downsampler only supports integral
-  // sampling rates, we first upsample by 11 to achieve an integral rate, then downsample to the output freq
-  static constexpr int             UPSAMPLE        = 11;
-  static constexpr int             MULTIPLIER      = 100;
-  static constexpr int             FREQ_A          = (39375000 * UPSAMPLE) / (22 * MULTIPLIER);
-  static constexpr int             OUTPUT_C        = 44100;      // Output freq
-  static constexpr SDL_AudioFormat OUTPUT_FORMAT   = AUDIO_U8;   // Unsigned 8-bit samples
-  static constexpr uint8_t         OUTPUT_CHANNELS = 1;          // Mono
-  static constexpr uint16_t        OUTPUT_SAMPLES  = (1 << 11);  // Buffer size, in samples
-                                                                 //   Seem to always get 2x less than requested
-
-  // We ensure the target audio buffer len is at least as long as the output device sample buffer, so that the audio
-  // device never runs dry.
-  //
-  // The resulting latency is the processing time of the downsampler plus the internal buffer size of the
-  // downsampler. This is approx 0.07sec, or 1/15th of a sec.
-  //
-  //  - The downsampler processing time has not yet been measured
-  //  - The upsampler outputs every 100 samples = 100*(22/39375000) ~= 0.000056sec
-  //  - The downsampler starts outputting after 41560 input samples = 41560*(22/39375000) ~= 0.023sec
-  //  - The TARGET_AUDIO_BUFFER_LEN = (2^11)/44100 ~= 0.045sec
-  //  - The OUTPUT_SAMPLES = (2^10)/44100 ~= 0.023sec, irrelevant since TARGET_AUDIO_BUFFER_LEN >= OUTPUT_SAMPLES
-  static constexpr size_t TARGET_AUDIO_BUFFER_LEN = (1 << 11);
-  static_assert(TARGET_AUDIO_BUFFER_LEN >= OUTPUT_SAMPLES);
-
-  float volume_ = 0.5;
-
-  SDL_AudioDeviceID device_;
-  SDL_AudioSpec     audio_spec_;
-  SDL_AudioStream*  downsampler_;
-};
-
-}  // namespace ui
+#pragma once
+
+#include <nesemu/hw/io.h>
+
+#include <algorithm>  // std::min
+#include <cstddef>    // size_t
+#include <cstdint>    // uint8_t, uint16_t
+
+#include <SDL2/SDL.h>
+
+
+namespace ui {
+
+class Speaker;
+void audio_callback(Speaker* speaker, uint8_t* stream, size_t len);
+
+class Speaker : public hw::io::AudioSink {
+public:
+  bool init();
+  void close();
+  void update(uint8_t* stream, size_t len) override;
+  void setVolume(float volume) { volume_ = std::max(std::min(volume, 1.f), 0.f); };
+  void addVolume(float delta) { volume_ = std::max(std::min(volume_ + delta, 1.f), 0.f); };
+  void pause(bool pause);
+
+  // Dynamic rate control. When enabled, the emulation speed should be steered by the fill level of the audio buffer
+  // rather than by the wall clock alone, so the audio callback never has to drop or stretch samples. Call updateRate()
+  // once per frame, and apply rateAdjustment() to the emulated clock. The audio thread reads the mode, so set it
+  // before init()
+  void  setDynamicRate(bool enable) { dynamic_rate_ = enable; }
+  void  updateRate();
+  float bufferLevel() const { return buffer_level_; }       // Queued samples relative to the target, 1.0 = on target
+  float rateAdjustment() const { return rate_adjustment_; }  // Emulation speed, within 1 +/- MAX_RATE_DELTA
+
+private:
+  friend void audio_callback(Speaker* speaker, uint8_t* stream, size_t len);
+
+  // We need to downsample from ~1.79MHz to a standard freq like 44.1kHz. Since the downsampler only supports integral
+  // sampling rates, we first upsample by 11 to achieve an integral rate, then downsample to the output freq
+  static constexpr int             UPSAMPLE        = 11;
+  static constexpr int             MULTIPLIER      = 100;
+  static constexpr int             FREQ_A          = (39375000 * UPSAMPLE) / (22 * MULTIPLIER);
+  static constexpr int             OUTPUT_C        = 44100;      // Output freq
+  static constexpr SDL_AudioFormat OUTPUT_FORMAT   = AUDIO_U8;   // Unsigned 8-bit samples
+  static constexpr uint8_t         OUTPUT_CHANNELS = 1;          // Mono
+  static constexpr uint16_t        OUTPUT_SAMPLES  = (1 << 11);  // Buffer size, in samples
+                                                                 //   Seem to always get 2x less than requested
+
+  // We ensure the target audio buffer len is at least as long as the output device sample buffer, so that the audio
+  // device never runs dry.
+  //
+  // The resulting latency is the processing time of the downsampler plus the internal buffer size of the
+  // downsampler. This is approx 0.07sec, or 1/15th of a sec.
+  //
+  //  - The downsampler processing time has not yet been measured
+  //  - The upsampler outputs every 100 samples = 100*(22/39375000) ~= 0.000056sec
+  //  - The downsampler starts outputting after 41560 input samples = 41560*(22/39375000) ~= 0.023sec
+  //  - The TARGET_AUDIO_BUFFER_LEN = (2^11)/44100 ~= 0.045sec
+  //  - The OUTPUT_SAMPLES = (2^10)/44100 ~= 0.023sec, irrelevant since TARGET_AUDIO_BUFFER_LEN >= OUTPUT_SAMPLES
+  static constexpr size_t TARGET_AUDIO_BUFFER_LEN = (1 << 11);
+  static_assert(TARGET_AUDIO_BUFFER_LEN >= OUTPUT_SAMPLES);
+
+  // With dynamic rate control, the buffer only needs to cover one device buffer plus one frame of samples, since the
+  // emulation speed is adjusted to hold it there. The speed is never adjusted by more than 0.5%, which is inaudible
+  static constexpr size_t DRC_FRAME_SAMPLES = OUTPUT_C / 60;
+  static constexpr float  MAX_RATE_DELTA    = 0.005;
+
+  size_t targetBufferLen() const {
+    return dynamic_rate_ ? audio_spec_.samples + DRC_FRAME_SAMPLES : TARGET_AUDIO_BUFFER_LEN;
+  }
+
+  float volume_ = 0.5;
+
+  // Upsampled samples not yet fed to the downsampler. Feeding it is slow, so it's fed in batches
+  static constexpr size_t UPSAMPLE_BATCH = 100;  // Input samples per batch
+
+  uint8_t upsample_buffer_[UPSAMPLE * UPSAMPLE_BATCH] = {0};
+  size_t  upsample_size_                              = {0};
+
+  bool startup_complete_ = {false};  // Whether the buffer has filled up once, see audio_callback()
+
+  bool  dynamic_rate_    = {false};
+  float buffer_level_    = {0};
+  float rate_adjustment_ = {1};
+
+  SDL_AudioDeviceID device_;
+  SDL_AudioSpec     audio_spec_;
+  SDL_AudioStream*  downsampler_;
+};
+
+}  // namespace ui
@@ -61,6 +61,7 @@ protected:
   bool keyboard_focus_ = {false};
   bool full_screen_    = {false};
   bool visible_        = {false};
+  bool warned_         = {false};  // Whether the missing update() override has been reported
 
   std::function<void(void)> on_close_;
 };
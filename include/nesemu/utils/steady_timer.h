@@ -2,25 +2,82 @@
 
 #include <nesemu/utils/lcm.h>
 
+#include <algorithm>  // std::max
 #include <chrono>
+#include <cstdint>  // intmax_t, uint64_t
 #include <thread>
 
 
 namespace utils {
 
+// How closely the deadlines of a SteadyTimer were met
+struct TimerStats {
+  using Duration = std::chrono::nanoseconds;
+
+  uint64_t waits     = {0};  // Number of deadlines waited for
+  uint64_t overruns  = {0};  // Number of deadlines which had already passed, ie. the emulation fell behind
+  Duration total_err = {};   // Sum of the wake-up errors (time woken after the deadline)
+  Duration max_err   = {};   // Largest wake-up error
+
+  Duration mean() const { return waits ? total_err / static_cast<Duration::rep>(waits) : Duration(0); }
+};
+
+
 template <intmax_t Num, intmax_t Den = 1>
 class SteadyTimer {
 public:
-  void start() { next_ = Clock::now() + Period(1); }
+  void start() {
+    next_    = Clock::now();
+    pending_ = 0;
+  }
+
+  // Advance the timer by one period. The thread only actually waits once every interval periods, so the cost of
+  // waiting is amortized over many ticks
+  void tick() {
+    if (++pending_ >= interval_) {
+      sleep();
+    }
+  }
 
+  // Advance the timer by several periods at once
+  void tick(unsigned periods) {
+    pending_ += periods;
+    if (pending_ >= interval_) {
+      sleep();
+    }
+  }
+
+  // Wait until all ticked periods have elapsed
   void sleep() {
-    // If skipping, call ready() to ensure that next_ is updated correctly
+    const TimePoint now = Clock::now();
+    next_               = std::max<TimePoint>(next_ + elapsed(), now - MAX_LAG);
+    pending_            = 0;
+
+    // If skipping, don't wait, but keep next_ up to date so that there's no burst when the limit is restored
     if (skip_) {
-      ready();
-    } else {
-      std::this_thread::sleep_until(next_);
-      next_ = std::max<TimePoint>(next_ + Period(1), Clock::now() - std::chrono::duration<Clock::rep, std::milli>(8));
+      next_ = std::max<TimePoint>(next_, now);
+      return;
     }
+
+    if (next_ <= now) {
+      stats_.overruns++;
+      return;
+    }
+
+    // Sleep until just before the deadline, then spin the remainder. sleep_until() routinely oversleeps by tens of
+    // microseconds, which is fine for a frame but not for a scanline
+    if (next_ - now > spin_) {
+      std::this_thread::sleep_until(next_ - spin_);
+    }
+    TimePoint woke = Clock::now();
+    while (woke < next_) {
+      woke = Clock::now();
+    }
+
+    const auto err = std::chrono::duration_cast<TimerStats::Duration>(woke - next_);
+    stats_.waits++;
+    stats_.total_err += err;
+    stats_.max_err = std::max(stats_.max_err, err);
   }
 
   bool ready() {
@@ -33,6 +90,19 @@ public:
 
   void skip(bool skip) { skip_ = skip; }
 
+  // Number of periods per wait, and how long before each deadline to stop sleeping and start spinning
+  void setInterval(unsigned interval, TimerStats::Duration spin) {
+    interval_ = std::max(interval, 1u);
+    spin_     = spin;
+  }
+
+  // Scale the speed of the timer, eg. 1.01 runs 1% fast
+  void   setRate(double rate) { rate_ = rate; }
+  double rate() const { return rate_; }
+
+  const TimerStats& stats() const { return stats_; }
+  void              resetStats() { stats_ = {}; }
+
 private:
   using Clock     = std::chrono::steady_clock;
   using Period    = std::chrono::duration<Clock::rep, std::ratio<Num, Den>>;
@@ -40,7 +110,24 @@ private:
       Clock,
       std::chrono::duration<Clock::rep, std::ratio<1, lcm::lcm(Clock::duration::period::den, Period::period::den)>>>;
 
-  bool      skip_ = {false};
-  TimePoint next_;
+  // Real time taken by the pending periods
+  typename TimePoint::duration elapsed() const {
+    if (rate_ == 1.0) {
+      return Period(pending_);
+    }
+    return std::chrono::duration_cast<typename TimePoint::duration>(
+        std::chrono::duration<double, typename Period::period>(pending_ / rate_));
+  }
+
+  // If the timer falls further behind than this, give up on catching up
+  static constexpr std::chrono::milliseconds MAX_LAG = std::chrono::milliseconds(8);
+
+  bool                 skip_     = {false};
+  double               rate_     = {1.0};
+  unsigned             interval_ = {1};
+  unsigned             pending_  = {0};
+  TimerStats::Duration spin_     = {};
+  TimePoint            next_;
+  TimerStats           stats_;
 };
 }  // namespace utils
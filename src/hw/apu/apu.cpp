@@ -1,13 +1,15 @@
 #include <nesemu/hw/apu/apu.h>
 
 #include <nesemu/hw/apu/apu_clock.h>
+#include <nesemu/hw/io.h>
 #include <nesemu/logger.h>
-#include <nesemu/ui/speaker.h>
+
+#include <algorithm>  // std::min, std::max
 
 
 // =*=*=*=*= APU Setup =*=*=*=*=
 
-void hw::apu::APU::setSpeaker(ui::Speaker* speaker) {
+void hw::apu::APU::setSpeaker(io::AudioSink* speaker) {
   speaker_ = speaker;
 }
 
@@ -100,6 +102,30 @@ void hw::apu::APU::clock() {
 }
 
 
+void hw::apu::APU::run(uint32_t cycles) {
+  for (; cycles > 0; cycles--) {
+    clock();
+  }
+}
+
+uint32_t hw::apu::APU::cyclesUntilEvent() const {
+  // The DMC requests DMAs and raises its interrupt (on the last DMA) by itself. Changes made by the CPU, through the
+  // registers, are its own business
+  uint32_t cycles = dmc.cyclesUntilDMA();
+
+  // The frame interrupt is raised at the end of the 4-step sequence. Resetting the frame counter only ever delays it
+  if (!has_irq_ && !frame_counter_mode_ && !irq_inhibit_) {
+    if (cycle_count_ <= 29830) {
+      cycles = std::min<uint32_t>(cycles, std::max<uint16_t>(cycle_count_, 29828) - cycle_count_ + 1);
+    } else {  // Only after switching from 5-step mode. The counter runs on until it resets
+      cycles = std::min<uint32_t>(cycles, 37282 - cycle_count_ + 1);
+    }
+  }
+
+  return cycles;
+}
+
+
 uint8_t hw::apu::APU::readRegister(uint16_t address) {
   if (address != 0x4015) {
     // Unknown register, or read-only register. Note that all registers except 0x4015 are write-only
@@ -109,14 +135,14 @@ uint8_t hw::apu::APU::readRegister(uint16_t address) {
   }
 
   // Status
-  static registers::StatusControl status = {0};
-  status.ch_1                            = square_1.status();
-  status.ch_2                            = square_2.status();
-  status.ch_3                            = triangle.status();
-  status.ch_4                            = noise.status();
-  status.ch_5                            = dmc.status();
-  status.frame_interrupt                 = has_irq_;
-  status.dmc_interrupt                   = dmc.hasIRQ();
+  registers::StatusControl status = {0};
+  status.ch_1                     = square_1.status();
+  status.ch_2                     = square_2.status();
+  status.ch_3                     = triangle.status();
+  status.ch_4                     = noise.status();
+  status.ch_5                     = dmc.status();
+  status.frame_interrupt          = has_irq_;
+  status.dmc_interrupt            = dmc.hasIRQ();
 
   // TODO: If an interrupt flag was set at the same moment of the read, it will read back as 1 but it will not be
   // cleared.
@@ -206,3 +232,30 @@ void hw::apu::APU::writeRegister(uint16_t address, uint8_t data) {
       break;
   }
 }
+
+
+// =*=*=*=*= APU Save States =*=*=*=*=
+
+void hw::apu::APU::saveState(state::Writer* out) const {
+  for (const channel::Channel* channel : channels) {
+    channel->saveState(out);
+  }
+  out->put(has_irq_);
+  out->put(sound_en_.raw);
+  out->put(irq_inhibit_);
+  out->put(frame_counter_mode_);
+  out->put(frame_counter_reset_counter_);
+  out->put(cycle_count_);
+}
+
+void hw::apu::APU::loadState(state::Reader* in) {
+  for (channel::Channel* channel : channels) {
+    channel->loadState(in);
+  }
+  in->get(has_irq_);
+  in->get(sound_en_.raw);
+  in->get(irq_inhibit_);
+  in->get(frame_counter_mode_);
+  in->get(frame_counter_reset_counter_);
+  in->get(cycle_count_);
+}
@@ -85,6 +85,16 @@ void hw::apu::channel::DMC::clockCPU() {
 }
 
 
+uint32_t hw::apu::channel::DMC::cyclesUntilDMA() const {
+  // Once the sample buffer has been filled, the next DMA is requested when it's emptied into the shifter, ie. when the
+  // timer has shifted out the remaining bits. Otherwise only a DMA or a register write can start one
+  if (!has_sample_ || dma_remaining_ == 0) {
+    return UINT32_MAX;
+  }
+  const uint32_t shifts = static_cast<uint8_t>(bits_remaining_ - 1);  // Timer outputs after the next one
+  return timer_.counter() + 1 + shifts * (timer_.period() + 1);
+}
+
 void hw::apu::channel::DMC::DMAPush(uint8_t data) {
   dma_active_    = false;
   sample_buffer_ = data;
@@ -105,3 +115,42 @@ void hw::apu::channel::DMC::DMAPush(uint8_t data) {
     }
   }
 }
+
+
+void hw::apu::channel::DMC::saveState(state::Writer* out) const {
+  Channel::saveState(out);
+  out->put(loop_);
+  out->put(IRQ_enable_);
+  out->put(sample_address_);
+  out->put(sample_length_);
+  timer_.saveState(out);
+  out->put(dma_active_);
+  out->put(dma_address_);
+  out->put(dma_remaining_);
+  out->put(sample_buffer_);
+  out->put(has_sample_);
+  out->put(bits_remaining_);
+  out->put(bit_buffer_);
+  out->put(output_);
+  out->put(silence_);
+  out->put(has_irq_);
+}
+
+void hw::apu::channel::DMC::loadState(state::Reader* in) {
+  Channel::loadState(in);
+  in->get(loop_);
+  in->get(IRQ_enable_);
+  in->get(sample_address_);
+  in->get(sample_length_);
+  timer_.loadState(in);
+  in->get(dma_active_);
+  in->get(dma_address_);
+  in->get(dma_remaining_);
+  in->get(sample_buffer_);
+  in->get(has_sample_);
+  in->get(bits_remaining_);
+  in->get(bit_buffer_);
+  in->get(output_);
+  in->get(silence_);
+  in->get(has_irq_);
+}
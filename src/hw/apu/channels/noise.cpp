@@ -56,3 +56,20 @@ void hw::apu::channel::Noise::clockFrame(APUClock clock_type) {
 uint8_t hw::apu::channel::Noise::getOutput() const {
   return (lfsr_ & 0x01) == 0 ? 0 : length_counter_.getOutput(envelope_.getOutput());
 }
+
+
+void hw::apu::channel::Noise::saveState(state::Writer* out) const {
+  StandardChannel::saveState(out);
+  out->put(lfsr_);
+  out->put(mode_);
+  timer_.saveState(out);
+  envelope_.saveState(out);
+}
+
+void hw::apu::channel::Noise::loadState(state::Reader* in) {
+  StandardChannel::loadState(in);
+  in->get(lfsr_);
+  in->get(mode_);
+  timer_.loadState(in);
+  envelope_.loadState(in);
+}
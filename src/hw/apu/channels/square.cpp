@@ -66,3 +66,26 @@ uint8_t hw::apu::channel::Square::getOutput() const {
   bool sequencer = SEQUENCE[duty_cycle_] & (1 << (8 - sequencer_.get()));
   return length_counter_.getOutput(sequencer ? sweep_.getOutput(envelope_.getOutput()) : 0);
 }
+
+
+void hw::apu::channel::Square::saveState(state::Writer* out) const {
+  StandardChannel::saveState(out);
+  out->put(clock_is_even_);
+  out->put(duty_cycle_);
+  out->put(period_);
+  timer_.saveState(out);
+  sequencer_.saveState(out);
+  envelope_.saveState(out);
+  sweep_.saveState(out);
+}
+
+void hw::apu::channel::Square::loadState(state::Reader* in) {
+  StandardChannel::loadState(in);
+  in->get(clock_is_even_);
+  in->get(duty_cycle_);
+  in->get(period_);
+  timer_.loadState(in);
+  sequencer_.loadState(in);
+  envelope_.loadState(in);
+  sweep_.loadState(in);
+}
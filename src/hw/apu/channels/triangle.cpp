@@ -49,3 +49,20 @@ void hw::apu::channel::Triangle::clockFrame(APUClock clock_type) {
       // No default
   }
 }
+
+
+void hw::apu::channel::Triangle::saveState(state::Writer* out) const {
+  StandardChannel::saveState(out);
+  out->put(period_);
+  timer_.saveState(out);
+  sequencer_.saveState(out);
+  linear_counter_.saveState(out);
+}
+
+void hw::apu::channel::Triangle::loadState(state::Reader* in) {
+  StandardChannel::loadState(in);
+  in->get(period_);
+  timer_.loadState(in);
+  sequencer_.loadState(in);
+  linear_counter_.loadState(in);
+}
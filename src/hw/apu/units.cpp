@@ -24,6 +24,24 @@ void hw::apu::unit::Envelope::clock() {
   }
 }
 
+void hw::apu::unit::Envelope::saveState(state::Writer* out) const {
+  divider_.saveState(out);
+  out->put(volume_);
+  out->put(const_volume_);
+  out->put(loop_);
+  out->put(start_);
+  out->put(decay_level_);
+}
+
+void hw::apu::unit::Envelope::loadState(state::Reader* in) {
+  divider_.loadState(in);
+  in->get(volume_);
+  in->get(const_volume_);
+  in->get(loop_);
+  in->get(start_);
+  in->get(decay_level_);
+}
+
 
 // =*=*=*=*= Sweep =*=*=*=*=
 
@@ -51,6 +69,22 @@ bool hw::apu::unit::Sweep::mute() const {
   return *channel_period_ < 8 || getTarget() > 0x7FF;
 }
 
+void hw::apu::unit::Sweep::saveState(state::Writer* out) const {
+  divider_.saveState(out);
+  out->put(shift_count_);
+  out->put(negate_);
+  out->put(enable_);
+  out->put(reload_);
+}
+
+void hw::apu::unit::Sweep::loadState(state::Reader* in) {
+  divider_.loadState(in);
+  in->get(shift_count_);
+  in->get(negate_);
+  in->get(enable_);
+  in->get(reload_);
+}
+
 
 // =*=*=*=*= Length Counter =*=*=*=*=
 
@@ -126,6 +160,16 @@ uint8_t hw::apu::unit::LengthCounter::getOutput(uint8_t input) const {
   return (counter_ == 0) ? 0 : input;
 }
 
+void hw::apu::unit::LengthCounter::saveState(state::Writer* out) const {
+  out->put(counter_);
+  out->put(halt_);
+}
+
+void hw::apu::unit::LengthCounter::loadState(state::Reader* in) {
+  in->get(counter_);
+  in->get(halt_);
+}
+
 
 // =*=*=*=*= Linear Counter =*=*=*=*=
 
@@ -144,3 +188,17 @@ void hw::apu::unit::LinearCounter::clock() {
 uint8_t hw::apu::unit::LinearCounter::getOutput(uint8_t input) const {
   return (counter_ == 0) ? 0 : input;
 }
+
+void hw::apu::unit::LinearCounter::saveState(state::Writer* out) const {
+  out->put(counter_);
+  out->put(reload_value_);
+  out->put(control_);
+  out->put(reload_);
+}
+
+void hw::apu::unit::LinearCounter::loadState(state::Reader* in) {
+  in->get(counter_);
+  in->get(reload_value_);
+  in->get(control_);
+  in->get(reload_);
+}
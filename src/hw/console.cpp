@@ -1,74 +1,198 @@
 #include <nesemu/hw/console.h>
 
+#include <nesemu/hw/mapper/mapper_types.h>
 #include <nesemu/hw/mapper/mappers.h>
 #include <nesemu/hw/rom.h>
+#include <nesemu/hw/state.h>
 #include <nesemu/logger.h>
-#include <nesemu/ui/screen.h>
-#include <nesemu/ui/speaker.h>
 
 #include <cstdint>
 
 
+hw::console::Console* hw::console::create(rom::Rom* rom, bool allow_unofficial_opcodes, bool generic) {
+  const uint8_t mapper_num = rom->header.mapper_upper << 4 | rom->header.mapper_lower;
+  logger::log<logger::DEBUG_MAPPER>("Using mapper #%d%s\n", mapper_num, generic ? " (generic)" : "");
+
+  const auto generator = generic ? internal::make<mapper::Mapper> : mapper::getConsole(mapper_num);
+  return generator(rom, allow_unofficial_opcodes);
+}
+
+
 // =*=*=*=*= Console Setup =*=*=*=*=
 
-hw::console::Console::Console(bool allow_unofficial_opcodes) {
+template <class MapperT>
+hw::console::internal::Console<MapperT>::Console(bool allow_unofficial_opcodes) {
   bus_.connectChips(&clock_, &apu_, &cpu_, &ppu_, &joy_1_, &joy_2_);
 
   cpu_.connectBus(&bus_);
   cpu_.allowUnofficialOpcodes(allow_unofficial_opcodes);
 }
 
-hw::console::Console::~Console() {
+template <class MapperT>
+hw::console::internal::Console<MapperT>::~Console() {
   if (mapper_ != nullptr) {
     delete mapper_;
   }
 }
 
-void hw::console::Console::loadCart(rom::Rom* rom) {
+template <class MapperT>
+int hw::console::internal::Console<MapperT>::loadCart(rom::Rom* rom) {
   // Setup the mapper
+  // The console was picked from the same registry entry as the mapper, so the mapper is always a MapperT
   const uint8_t           mapper_num = rom->header.mapper_upper << 4 | rom->header.mapper_lower;
   const mapper::Mirroring mirror     = rom->header.ignore_mirroring
                                            ? mapper::Mirroring::none
                                            : (rom->header.nametable_mirror ? mapper::Mirroring::vertical
                                                                            : mapper::Mirroring::horizontal);
-  logger::log<logger::DEBUG_MAPPER>("Using mapper #%d\n", mapper_num);
-  mapper_ = mapper::getMapper(mapper_num)(rom->header.prg_rom_size, rom->header.chr_rom_size, mirror);
+  mapper_ = static_cast<MapperT*>(
+      mapper::getMapper(mapper_num)(rom->header.prg_rom_size, rom->header.chr_rom_size, mirror));
+  if (!mapper_) {
+    return 1;
+  }
 
   // Load the rom and mapper onto the busses
-  bus_.loadCart(mapper_, rom->prg[0], (rom->header.has_battery ? rom->expansion[0] : nullptr));
-  ppu_.loadCart(mapper_, rom->chr[0], (rom->header.chr_rom_size == 0));
+  mapper_->connectMemory(rom->prg[0], rom->chr[0]);
+  bus_.loadCart(mapper_, (rom->header.has_battery ? rom->expansion[0] : nullptr));
+  cpu_.loadCart(rom->prg[0], rom->header.prg_rom_size * 0x4000);
+  ppu_.loadCart(mapper_, (rom->header.chr_rom_size == 0));
+
+  mapper_num_ = mapper_num;
+  crc_        = rom->crc;
+  state::Writer sizer(nullptr);
+  writeState(&sizer);
+  state_size_ = sizer.size();
+  return 0;
 }
 
-void hw::console::Console::setScreen(ui::Screen* screen) {
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::setScreen(io::VideoSink* screen) {
   screen_ = screen;
   ppu_.setScreen(screen_);
 }
 
-void hw::console::Console::setSpeaker(ui::Speaker* speaker) {
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::setSpeaker(io::AudioSink* speaker) {
   speaker_ = speaker;
   apu_.setSpeaker(speaker_);
 }
 
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::setInput(io::InputSource* input) {
+  input_ = input;
+  joy_1_.setInput(input_);
+  joy_2_.setInput(input_);
+}
+
 
 // =*=*=*=*= Console Execution =*=*=*=*=
 
-void hw::console::Console::start() {
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::start() {
+  const logger::Scope log_scope(log_level_);
   clock_.start();
   cpu_.reset(true);
   cpu_.executeInstruction();
   cpu_.reset(false);
 }
 
-void hw::console::Console::update() {
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::update() {
+  const logger::Scope log_scope(log_level_);
   cpu_.reset(reset_);
   // TODO: Reset APU & PPU regs
-  cpu_.executeInstruction();
+  if (backend_ == cpu::Backend::BLOCKS) {
+    cpu_.executeBlock();
+  } else {
+    cpu_.executeInstruction();
+  }
+}
+
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::runFrame() {
+  const logger::Scope log_scope(log_level_);
+  const uint64_t      frame = ppu_.frameCount();
+  runUntil([&]() { return ppu_.frameCount() != frame; });
+  bus_.sync();
 }
 
-void hw::console::Console::reset(bool reset) {
+template <class MapperT>
+uint64_t hw::console::internal::Console<MapperT>::runCycles(uint64_t cycles) {
+  const logger::Scope log_scope(log_level_);
+  const uint64_t      start = bus_.cycles();
+  runUntil([&]() { return bus_.cycles() - start >= cycles; });
+  bus_.sync();
+  return bus_.cycles() - start;
+}
+
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::reset(bool reset) {
   reset_ = reset;
   // speaker_->pause(reset_);
   if (!reset_) {
     clock_.start();
   }
 }
+
+
+// =*=*=*=*= Console Save States =*=*=*=*=
+
+template <class MapperT>
+int hw::console::internal::Console<MapperT>::loadState(const std::vector<uint8_t>& state) {
+  state::Reader       in(state.data(), state.size());
+  const state::Header header = in.get<state::Header>();
+  if (in.failed() || header.magic != state::MAGIC || header.version != state::VERSION) {
+    logger::log<logger::ERROR>("Not a save state, or from another version\n");
+    return 1;
+  }
+  if (header.mapper != mapper_num_ || header.crc != crc_ || header.size != state_size_ || state.size() != state_size_) {
+    logger::log<logger::ERROR>("Save state is for another cartridge\n");
+    return 1;
+  }
+  return restore(state);
+}
+
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::snapshot(std::vector<uint8_t>* buffer) {
+  bus_.sync();  // So every chip's state is at the same cycle
+  buffer->resize(state_size_);
+  state::Writer out(buffer->data());
+  writeState(&out);
+}
+
+template <class MapperT>
+int hw::console::internal::Console<MapperT>::restore(const std::vector<uint8_t>& buffer) {
+  if (buffer.size() != state_size_) {
+    return 1;
+  }
+  state::Reader in(buffer.data() + sizeof(state::Header), buffer.size() - sizeof(state::Header));
+  readState(&in);
+  return 0;
+}
+
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::writeState(state::Writer* out) const {
+  out->put(state::Header{state::MAGIC, state::VERSION, mapper_num_, crc_, static_cast<uint32_t>(state_size_)});
+  mapper_->saveState(out);
+  cpu_.saveState(out);
+  ppu_.saveState(out);
+  apu_.saveState(out);
+  joy_1_.saveState(out);
+  joy_2_.saveState(out);
+  bus_.saveState(out);
+}
+
+// The bus goes last, see system_bus::SystemBus::loadState
+template <class MapperT>
+void hw::console::internal::Console<MapperT>::readState(state::Reader* in) {
+  mapper_->loadState(in);
+  cpu_.loadState(in);
+  ppu_.loadState(in);
+  apu_.loadState(in);
+  joy_1_.loadState(in);
+  joy_2_.loadState(in);
+  bus_.loadState(in);
+}
+
+
+#define INSTANTIATE(MapperT) template class hw::console::internal::Console<MapperT>;
+NESEMU_FOR_EACH_MAPPER(INSTANTIATE)
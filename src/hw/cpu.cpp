@@ -1,9 +1,12 @@
 #include <nesemu/hw/cpu.h>
 
+#include <nesemu/hw/mapper/mapper_types.h>
+#include <nesemu/hw/ppu.h>
 #include <nesemu/hw/system_bus.h>
 #include <nesemu/logger.h>
 #include <nesemu/utils/enum.h>
 
+#include <algorithm>  // std::fill, std::min
 #include <iostream>
 
 
@@ -12,1061 +15,1097 @@
 template <typename... T>
 inline void log(uint16_t addr, uint8_t opcode, const char* format, T... args) {
   static constexpr size_t MAX_SIZE = 256;
-  static char             BUFFER[MAX_SIZE];
+  char                    buffer[MAX_SIZE];
 
-  snprintf(BUFFER, MAX_SIZE, "$%04X> $%02X %s", addr, opcode, format);
-  logger::log<logger::DEBUG_CPU>(BUFFER, args...);
+  snprintf(buffer, MAX_SIZE, "$%04X> $%02X %s", addr, opcode, format);
+  logger::log<logger::DEBUG_CPU>(buffer, args...);
 }
 
 
 // =*=*=*=*= CPU Setup =*=*=*=*=
 
-void hw::cpu::CPU::allowUnofficialOpcodes(bool allow) {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::allowUnofficialOpcodes(bool allow) {
   allow_unofficial_ = allow;
+  std::fill(decoded_.begin(), decoded_.end(), Decoded());
+  blocks_.clear();
 }
 
-void hw::cpu::CPU::connectBus(system_bus::SystemBus* bus) {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::skipIdleLoops(bool skip) {
+  skip_idle_loops_ = skip;
+}
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::connectBus(system_bus::SystemBus<MapperT>* bus) {
   bus_ = bus;
 }
 
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::loadCart(const uint8_t* prg_rom, std::size_t prg_size) {
+  prg_rom_ = prg_rom;
+  decoded_.assign(prg_size, Decoded());
+  blocks_.clear();
+}
+
 
 // =*=*=*=*= CPU Execution =*=*=*=*=
 
-void hw::cpu::CPU::executeInstruction() {
-  using utils::asInt;
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::executeInstruction() {
 
   // If there is a pending interrupt:
-  if (irq_reset_ || do_nmi_[1] || irq_brk_ || do_irq_[1]) {
+  if (hasInterrupt()) {
     interrupt();
     return;
   }
 
 #if DEBUG
-  static uint16_t next_op = PC;
-  printf("Next op address: $%04X", next_op);
-  if (next_op <= PC) {
-    std::cin >> std::hex >> std::noskipws >> next_op;
+  printf("Next op address: $%04X", next_op_);
+  if (next_op_ <= PC) {
+    std::cin >> std::hex >> std::noskipws >> next_op_;
   }
 #endif
 
-  // Fetch next instruction from PC
-  const uint16_t opcode_addr = PC++;
-  const uint8_t  opcode      = readByte(opcode_addr);
-
-  switch (opcode) {
-
-    // =*=*=*=*= Official Opcodes =*=*=*=*=
-
-    // Add with carry
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::ADC) + asInt(AddressingMode::indirect_y)): {
-      const uint8_t arg    = readByte(getArgAddr(opcode - asInt(Instruction::ADC), true));
-      const uint8_t result = A + arg + P.c;
-      P.c                  = ((A + arg + P.c) >> 8) & 0x01;
-      P.z                  = (result == 0);
-      P.v                  = (A >> 7 == arg >> 7) && (A >> 7 != result >> 7);
-      P.n                  = (result >> 7);
-      A                    = result;
-      log(opcode_addr, opcode, "ADC:       A <- $%02X\n", A);
-    } break;
-
-
-    // Bitwise AND with accumulator
-    case (asInt(Instruction::AND) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::AND) + asInt(AddressingMode::indirect_y)): {
-      A &= readByte(getArgAddr(opcode - asInt(Instruction::AND), true));
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "AND:       A <- $%02X\n", A);
-    } break;
-
-
-    // Arithmetic shift left
-    case (asInt(Instruction::ASL) + asInt(AddressingMode::accumulator)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.c = (A >> 7);
-      A <<= 1;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "ASL:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::ASL) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::ASL) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::ASL) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::ASL) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::ASL));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      P.c = (arg >> 7);
-      arg <<= 1;
-      P.z = (arg == 0);
-      P.n = (arg >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "ASL:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // Test bits
-    case (asInt(Instruction::BIT) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::BIT) + asInt(AddressingMode::absolute)): {
-      const uint8_t arg = readByte(getArgAddr(opcode - asInt(Instruction::BIT)));
-      P.z               = ((A & arg) == 0);
-      P.v               = (arg >> 6) & 0x01;
-      P.n               = (arg >> 7);
-      log(opcode_addr, opcode, "BIT:     $%02X\n", arg);
-    } break;
-
-
-    // Branch
-    case (asInt(Instruction::BPL) + asInt(AddressingMode::relative)):
-      branch(!P.n);
-      log(opcode_addr, opcode, "BPL\n");
-      break;
-    case (asInt(Instruction::BMI) + asInt(AddressingMode::relative)):
-      branch(P.n);
-      log(opcode_addr, opcode, "BMI\n");
-      break;
-    case (asInt(Instruction::BVC) + asInt(AddressingMode::relative)):
-      branch(!P.v);
-      log(opcode_addr, opcode, "BVC\n");
-      break;
-    case (asInt(Instruction::BVS) + asInt(AddressingMode::relative)):
-      branch(P.v);
-      log(opcode_addr, opcode, "BVS\n");
-      break;
-    case (asInt(Instruction::BCC) + asInt(AddressingMode::relative)):
-      branch(!P.c);
-      log(opcode_addr, opcode, "BCC\n");
-      break;
-    case (asInt(Instruction::BCS) + asInt(AddressingMode::relative)):
-      branch(P.c);
-      log(opcode_addr, opcode, "BCS\n");
-      break;
-    case (asInt(Instruction::BNE) + asInt(AddressingMode::relative)):
-      branch(!P.z);
-      log(opcode_addr, opcode, "BNE\n");
-      break;
-    case (asInt(Instruction::BEQ) + asInt(AddressingMode::relative)):
-      branch(P.z);
-      log(opcode_addr, opcode, "BEQ\n");
-      break;
-
-
-    // Break
-    case (asInt(Instruction::BRK) + asInt(AddressingMode::implied)):
-      readByte(PC++);  // Padding byte
-
-      P.b = 0b11;
-      push(PC >> 8);
-      push(PC);
-
-      irq_brk_ = true;
-      log(opcode_addr, opcode, "BRK\n");
-      break;
-
-
-    // Compare accumulator
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::CMP) + asInt(AddressingMode::indirect_y)): {
-      const uint8_t arg = readByte(getArgAddr(opcode - asInt(Instruction::CMP), true));
-      P.z               = (A == arg);
-      P.c               = (A >= arg);
-      P.n               = ((A - arg) >> 7);
-      log(opcode_addr, opcode, "CMP:     $%02X\n", arg);
-    } break;
-
-
-    // Compare X register
-    case (asInt(Instruction::CPX) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::CPX) + asInt(AddressingMode::alt_zero_page)):
-    case (asInt(Instruction::CPX) + asInt(AddressingMode::alt_absolute)): {
-      AddressingMode mode = AddressingMode::immediate;
-      if (opcode == asInt(Instruction::CPX) + asInt(AddressingMode::alt_zero_page)) {
-        mode = AddressingMode::zero_page;
-      } else if (opcode == asInt(Instruction::CPX) + asInt(AddressingMode::alt_absolute)) {
-        mode = AddressingMode::absolute;
-      }
+  // Fetch next instruction from PC. Instructions in PRG ROM are only decoded once
+  const uint16_t opcode_addr = PC;
+  if (const Decoded* decoded = decode(opcode_addr)) {
+    executeDecoded(decoded);
+  } else {
+    const uint8_t opcode = fetch();
+    (this->*HANDLERS[allow_unofficial_][opcode])(opcode_addr, opcode);
+  }
 
-      const uint8_t arg = readByte(getArgAddr(mode));
-      P.z               = (X == arg);
-      P.c               = (X >= arg);
-      P.n               = ((X - arg) >> 7);
-      log(opcode_addr, opcode, "CPX:     $%02X\n", arg);
-    } break;
-
-
-    // Compare Y register
-    case (asInt(Instruction::CPY) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::CPY) + asInt(AddressingMode::alt_zero_page)):
-    case (asInt(Instruction::CPY) + asInt(AddressingMode::alt_absolute)): {
-      AddressingMode mode = AddressingMode::immediate;
-      if (opcode == asInt(Instruction::CPY) + asInt(AddressingMode::alt_zero_page)) {
-        mode = AddressingMode::zero_page;
-      } else if (opcode == asInt(Instruction::CPY) + asInt(AddressingMode::alt_absolute)) {
-        mode = AddressingMode::absolute;
-      }
+  // Jumped backwards, so may be in an idle loop
+  if (skip_idle_loops_ && PC <= opcode_addr) {
+    skipIdleLoop();
+  }
 
-      const uint8_t arg = readByte(getArgAddr(mode));
-      P.z               = (Y == arg);
-      P.c               = (Y >= arg);
-      P.n               = ((Y - arg) >> 7);
-      log(opcode_addr, opcode, "CPY:     $%02X\n", arg);
-    } break;
-
-
-    // Decrement memory
-    case (asInt(Instruction::DEC) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::DEC) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::DEC) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::DEC) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::DEC));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      arg -= 1;
-      P.z = (arg == 0);
-      P.n = (arg >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "DEC:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // Bitwise exclusive OR
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::EOR) + asInt(AddressingMode::indirect_y)): {
-      A ^= readByte(getArgAddr(opcode - asInt(Instruction::EOR), true));
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "EOR:       A <- $%02X\n", A);
-    } break;
-
-
-    // Flag (Processor Status) manipulation
-    case (asInt(Instruction::CLC) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.c = false;
-      log(opcode_addr, opcode, "CLC\n");
-      break;
-    case (asInt(Instruction::SEC) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.c = true;
-      log(opcode_addr, opcode, "SEC\n");
-      break;
-    case (asInt(Instruction::CLI) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.i = false;
-      log(opcode_addr, opcode, "CLI\n");
-      break;
-    case (asInt(Instruction::SEI) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.i = true;
-      log(opcode_addr, opcode, "SEI\n");
-      break;
-    case (asInt(Instruction::CLV) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.v = false;
-      log(opcode_addr, opcode, "CLV\n");
-      break;
-    case (asInt(Instruction::CLD) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.d = false;
-      log(opcode_addr, opcode, "CLD\n");
-      break;
-    case (asInt(Instruction::SED) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.d = true;
-      log(opcode_addr, opcode, "SED\n");
-      break;
-
-
-    // Increment memory
-    case (asInt(Instruction::INC) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::INC) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::INC) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::INC) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::INC));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      arg += 1;
-      P.z = (arg == 0);
-      P.n = (arg >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "INC:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // Jump
-    case (asInt(Instruction::JMP) + asInt(AddressingMode::immediate)):  // Irregular opcode, actually absolute
-      PC = getArgAddr(AddressingMode::absolute);
-      log(opcode_addr, opcode, "JMP:   $%04X\n", PC);
-      break;
-    case (asInt(Instruction::JMP) + asInt(AddressingMode::indirect)): {  // Like indirect, but with page wrap bug
-      uint16_t addr = readByte(PC++);
-      addr |= (readByte(PC++) << 8);
-      const uint16_t page = addr & 0xFF00;
-      PC                  = readByte(addr) | (readByte(((addr + 1) & 0x00FF) | page) << 8);
-      log(opcode_addr, opcode, "JMP:   $%04X\n", PC);
-    } break;
-
-
-    // Jump to service routine
-    case (asInt(Instruction::JSR) + asInt(AddressingMode::absolute)): {
-      const uint16_t address = getArgAddr(AddressingMode::absolute);
-      tick();  // Unknown extra cycle (Pre-decrement S?)
-      push((PC - 1) >> 8);
-      push(PC - 1);
-      PC = address;
-      log(opcode_addr, opcode, "JSR:   $%04X\n", PC);
-    } break;
-
-
-    // Load accumulator
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::LDA) + asInt(AddressingMode::indirect_y)): {
-      A   = readByte(getArgAddr(opcode - asInt(Instruction::LDA), true));
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "LDA:       A <- $%02X\n", A);
-    } break;
-
-
-    // Load X register
-    case (asInt(Instruction::LDX) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::LDX) + asInt(AddressingMode::alt_zero_page)):
-    case (asInt(Instruction::LDX) + asInt(AddressingMode::alt_zero_page_y)):
-    case (asInt(Instruction::LDX) + asInt(AddressingMode::alt_absolute)):
-    case (asInt(Instruction::LDX) + asInt(AddressingMode::alt_absolute_y)): {
-      AddressingMode mode = AddressingMode::immediate;
-      if (opcode == asInt(Instruction::LDX) + asInt(AddressingMode::alt_zero_page)) {
-        mode = AddressingMode::zero_page;
-      } else if (opcode == asInt(Instruction::LDX) + asInt(AddressingMode::alt_zero_page_y)) {
-        mode = AddressingMode::zero_page_y;
-      } else if (opcode == asInt(Instruction::LDX) + asInt(AddressingMode::alt_absolute)) {
-        mode = AddressingMode::absolute;
-      } else if (opcode == asInt(Instruction::LDX) + asInt(AddressingMode::alt_absolute_y)) {
-        mode = AddressingMode::absolute_y;
-      }
+#if DEBUG
+  if (std::cin.fail()) {
+    std::cin.clear();
+    std::cin.ignore();
+    next_op_ = PC;
+  }
+#endif
+}
 
-      X   = readByte(getArgAddr(mode, true));
-      P.z = (X == 0);
-      P.n = (X >> 7);
-      log(opcode_addr, opcode, "LDX:       X <- $%02X\n", X);
-    } break;
-
-
-    // Load Y register
-    case (asInt(Instruction::LDY) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::LDY) + asInt(AddressingMode::alt_zero_page)):
-    case (asInt(Instruction::LDY) + asInt(AddressingMode::alt_zero_page_x)):
-    case (asInt(Instruction::LDY) + asInt(AddressingMode::alt_absolute)):
-    case (asInt(Instruction::LDY) + asInt(AddressingMode::alt_absolute_x)): {
-      AddressingMode mode = AddressingMode::immediate;
-      if (opcode == asInt(Instruction::LDY) + asInt(AddressingMode::alt_zero_page)) {
-        mode = AddressingMode::zero_page;
-      } else if (opcode == asInt(Instruction::LDY) + asInt(AddressingMode::alt_zero_page_x)) {
-        mode = AddressingMode::zero_page_x;
-      } else if (opcode == asInt(Instruction::LDY) + asInt(AddressingMode::alt_absolute)) {
-        mode = AddressingMode::absolute;
-      } else if (opcode == asInt(Instruction::LDY) + asInt(AddressingMode::alt_absolute_x)) {
-        mode = AddressingMode::absolute_x;
-      }
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::executeBlock() {
+  const Block* block = hasInterrupt() ? nullptr : translate(PC);
+  if (!block) {
+    executeInstruction();
+    return;
+  }
 
-      Y   = readByte(getArgAddr(mode, true));
-      P.z = (Y == 0);
-      P.n = (Y >> 7);
-      log(opcode_addr, opcode, "LDY:       Y <- $%02X\n", Y);
-    } break;
-
-
-    // Logical shift right
-    case (asInt(Instruction::LSR) + asInt(AddressingMode::accumulator)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.c = (A & 0x01);
-      A >>= 1;
-      P.z = (A == 0);
-      P.n = (A >> 7);  // Always 0
-      log(opcode_addr, opcode, "LSR:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::LSR) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::LSR) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::LSR) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::LSR) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::LSR));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      P.c = (arg & 0x01);
-      arg >>= 1;
-      P.z = (arg == 0);
-      P.n = (arg >> 7);  // Always 0
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "LSR:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // No operation
-    case (asInt(Instruction::NOP) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      log(opcode_addr, opcode, "NOP\n");
-      break;
-
-
-    // Logical inclusive OR
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::ORA) + asInt(AddressingMode::indirect_y)): {
-      A |= readByte(getArgAddr(opcode - asInt(Instruction::ORA), true));
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "ORA:       A <- $%02X\n", A);
-    } break;
-
-
-    // Register manipulation
-    case (asInt(Instruction::TAX) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      X   = A;
-      P.z = (X == 0);
-      P.n = (X >> 7);
-      log(opcode_addr, opcode, "TAX:       X <- $%02X\n", X);
-    } break;
-    case (asInt(Instruction::TXA) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      A   = X;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "TXA:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::DEX) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      X--;
-      P.z = (X == 0);
-      P.n = (X >> 7);
-      log(opcode_addr, opcode, "DEX:       X <- $%02X\n", X);
-    } break;
-    case (asInt(Instruction::INX) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      X++;
-      P.z = (X == 0);
-      P.n = (X >> 7);
-      log(opcode_addr, opcode, "INX:       X <- $%02X\n", X);
-    } break;
-    case (asInt(Instruction::TAY) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      Y   = A;
-      P.z = (Y == 0);
-      P.n = (Y >> 7);
-      log(opcode_addr, opcode, "TAY:       Y <- $%02X\n", Y);
-    } break;
-    case (asInt(Instruction::TYA) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      A   = Y;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "TAY:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::DEY) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      Y--;
-      P.z = (Y == 0);
-      P.n = (Y >> 7);
-      log(opcode_addr, opcode, "DEY:       Y <- $%02X\n", Y);
-    } break;
-    case (asInt(Instruction::INY) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      Y++;
-      P.z = (Y == 0);
-      P.n = (Y >> 7);
-      log(opcode_addr, opcode, "INY:       Y <- $%02X\n", Y);
-    } break;
-
-
-    // Rotate left
-    case (asInt(Instruction::ROL) + asInt(AddressingMode::accumulator)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      const bool old_carry = (A >> 7);
-      A                    = (A << 1) | P.c;
-      P.c                  = old_carry;
-      P.z                  = (A == 0);
-      P.n                  = (A >> 7);
-      log(opcode_addr, opcode, "ROL:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::ROL) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::ROL) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::ROL) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::ROL) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::ROL));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      const bool old_carry = (arg >> 7);
-      arg                  = (arg << 1) | P.c;
-      P.c                  = old_carry;
-      P.z                  = (arg == 0);
-      P.n                  = (arg >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "ROL:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // Rotate right
-    case (asInt(Instruction::ROR) + asInt(AddressingMode::accumulator)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      const bool old_carry = (A & 0x01);
-      A                    = (A >> 1) | (P.c << 7);
-      P.c                  = old_carry;
-      P.z                  = (A == 0);
-      P.n                  = (A >> 7);
-      log(opcode_addr, opcode, "ROR:       A <- $%02X\n", A);
-    } break;
-    case (asInt(Instruction::ROR) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::ROR) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::ROR) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::ROR) + asInt(AddressingMode::absolute_x)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::ROR));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      const bool old_carry = (arg & 0x01);
-      arg                  = (arg >> 1) | (P.c << 7);
-      P.c                  = old_carry;
-      P.z                  = (arg == 0);
-      P.n                  = (arg >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "ROR:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // Return from interrupt
-    case (asInt(Instruction::RTI) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      tick();        // Increment stack pointer
-      P.raw = pop() & 0xCF;
-      PC    = pop() | pop() << 8;
-      log(opcode_addr, opcode, "RTI:   $%04X\n", PC);
-    } break;
-
-
-    // Return from subroutine
-    case (asInt(Instruction::RTS) + asInt(AddressingMode::implied)): {
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      tick();        // Increment stack pointer
-      PC = (pop() | pop() << 8) + 1;
-      tick();  // Increment PC
-      log(opcode_addr, opcode, "RTS:   $%04X\n", PC);
-    } break;
-
-
-    // Subtract with carry
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::immediate)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::SBC) + asInt(AddressingMode::indirect_y)): {
-      const uint8_t  arg      = readByte(getArgAddr(opcode - asInt(Instruction::SBC), true));
-      const uint16_t res_long = A + ~arg + P.c;
-      const uint8_t  result   = res_long;
-      P.c                     = !((res_long >> 8) & 0x01);
-      P.z                     = (result == 0);
-      P.v                     = (A >> 7 != arg >> 7) && (A >> 7 != result >> 7);
-      P.n                     = (result >> 7);
-      A                       = result;
-      log(opcode_addr, opcode, "SBC:       A <- $%02X\n", A);
-    } break;
-
-
-    // Store accumulator
-    case (asInt(Instruction::STA) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::absolute)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::absolute_x)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::absolute_y)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::indirect_x)):
-    case (asInt(Instruction::STA) + asInt(AddressingMode::indirect_y)): {
-      AddressingMode mode = AddressingMode(opcode - asInt(Instruction::STA));
-      const uint16_t addr = getArgAddr(mode);
-
-      writeByte(addr, A);
-      log(opcode_addr, opcode, "STA:   $%04X <- $%02X\n", addr, A);
-    } break;
-
-
-    // Stack manipulation
-    case (asInt(Instruction::TXS) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      SP = X;
-      log(opcode_addr, opcode, "TXS:      SP <- $%02X\n", SP);
-      break;
-    case (asInt(Instruction::TSX) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      X   = SP;
-      P.z = (X == 0);
-      P.n = (X >> 7);
-      log(opcode_addr, opcode, "TSX:       X <- $%02X\n", X);
-      break;
-    case (asInt(Instruction::PHA) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      push(A);
-      log(opcode_addr, opcode, "PHA:      SP <- $%02X\n", A);
-      break;
-    case (asInt(Instruction::PLA) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      tick();        // Increment stack pointer
-      A   = pop();
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "PLA:       A <- $%02X\n", A);
-      break;
-    case (asInt(Instruction::PHP) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      P.b = 0b11;
-      push(P.raw);
-      P.b = 0;
-      log(opcode_addr, opcode, "PHP:      SP <- $%02X\n", P.raw);
-      break;
-    case (asInt(Instruction::PLP) + asInt(AddressingMode::implied)):
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      tick();        // Increment stack pointer
-      P.raw = pop() & 0xCF;
-      log(opcode_addr, opcode, "PHP:       P <- $%02X\n", P.raw);
-      break;
-
-
-    // Store X register
-    case (asInt(Instruction::STX) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::STX) + asInt(AddressingMode::zero_page_x)):  // Should be zero_page_y
-    case (asInt(Instruction::STX) + asInt(AddressingMode::absolute)): {
-      uint16_t addr;
-      if (opcode == asInt(Instruction::STX) + asInt(AddressingMode::zero_page_x)) {
-        addr = getArgAddr(AddressingMode::zero_page_y);
-      } else {
-        addr = getArgAddr(opcode - asInt(Instruction::STX));
-      }
-      writeByte(addr, X);
-      log(opcode_addr, opcode, "STX:   $%04X <- $%02X\n", addr, X);
-    } break;
+  const uint16_t start          = PC;
+  const uint64_t prg_generation = bus_->prgGeneration();
+  for (const Decoded* decoded : block->instructions) {
+    executeDecoded(decoded);
 
+    // Leave early to service interrupts, or if the rest of the block may have been switched out
+    if (hasInterrupt() || bus_->prgGeneration() != prg_generation) {
+      return;
+    }
+  }
 
-    // Store Y register
-    case (asInt(Instruction::STY) + asInt(AddressingMode::zero_page)):
-    case (asInt(Instruction::STY) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(Instruction::STY) + asInt(AddressingMode::absolute)): {
-      const uint16_t addr = getArgAddr(opcode - asInt(Instruction::STY));
-      writeByte(addr, Y);
-      log(opcode_addr, opcode, "STX:   $%04X <- $%02X\n", addr, Y);
-    } break;
+  if (skip_idle_loops_ && PC == start && block->idle) {
+    skipIdleLoop();
+  }
+}
 
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::reset(bool active) {
+  irq_reset_ = active;
+  if (!irq_reset_) {
+    reset_ready_ = false;
+  }
+}
 
-    // =*=*=*=*= Unofficial Opcodes =*=*=*=*=
 
-    // ALR: AND #i then LSR A
-    case (asInt(UnofficialInstruction::ALR) + asInt(AddressingMode::immediate)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      A &= readByte(getArgAddr(AddressingMode::immediate));
-      P.c = (A & 0x01);
-      A >>= 1;
-      P.z = (A == 0);
-      P.n = (A >> 7);  // Always 0
-      log(opcode_addr, opcode, "ALR:       A <- $%02X\n", A);
-      break;
-
-
-    // ANC: AND #i then C<-N
-    case (asInt(UnofficialInstruction::ANC_1) + asInt(AddressingMode::immediate)):
-    case (asInt(UnofficialInstruction::ANC_2) + asInt(AddressingMode::immediate)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      A &= readByte(getArgAddr(AddressingMode::immediate));
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      P.c = P.n;
-      log(opcode_addr, opcode, "ANC:       A <- $%02X\n", A);
-      break;
-
-
-    // ARR: AND #i then ROR A, but with different flags
-    case (asInt(UnofficialInstruction::ARR) + asInt(AddressingMode::immediate)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      A &= readByte(getArgAddr(AddressingMode::immediate));
-      A   = (A >> 1) | (P.c << 7);
-      P.c = (A >> 6) & 0x01;
-      P.z = (A == 0);
-      P.v = P.c ^ ((A >> 5) & 0x01);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "ARR:       A <- $%02X\n", A);
-      break;
-
-
-    // LAX: LDR then TAX
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::zero_page_x)):  // Should be zero_page_y
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::absolute_x)):  // Should be absolute_y
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::LAX) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      AddressingMode mode = AddressingMode(opcode - asInt(UnofficialInstruction::LAX));
-      if (mode == AddressingMode::zero_page_x) {
-        mode = AddressingMode::zero_page_y;
-      } else if (mode == AddressingMode::absolute_x) {
-        mode = AddressingMode::absolute_y;
-      }
+// =*=*=*=*= CPU Save States =*=*=*=*=
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::saveState(state::Writer* out) const {
+  out->put(PC);
+  out->put(SP);
+  out->put(A);
+  out->put(X);
+  out->put(Y);
+  out->put(P.raw);
+  out->put(prev_nmi_);
+  out->put(irq_reset_);
+  out->put(irq_brk_);
+  out->put(do_poll_interrupts_);
+  out->put(do_nmi_);
+  out->put(do_irq_);
+  out->put(reset_ready_);
+}
 
-      A   = readByte(getArgAddr(mode, true));
-      X   = A;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "LAX:       A <- $%02X\n", A);
-    } break;
-
-
-    // SAX: Store A & X
-    case (asInt(UnofficialInstruction::SAX) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::SAX) + asInt(AddressingMode::zero_page_x)):  // Should be zero_page_y
-    case (asInt(UnofficialInstruction::SAX) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::SAX) + asInt(AddressingMode::indirect_x)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      AddressingMode mode = AddressingMode(opcode - asInt(UnofficialInstruction::SAX));
-      if (mode == AddressingMode::zero_page_x) {
-        mode = AddressingMode::zero_page_y;
-      }
-      const uint16_t addr = getArgAddr(mode);
-      writeByte(addr, A & X);
-      log(opcode_addr, opcode, "SAX:   $%04X <- $%02X\n", addr, A & X);
-    } break;
-
-
-    // DCP: DEC then CMP
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::DCP) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::DCP));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      arg -= 1;
-      P.z = (A == arg);
-      P.c = (A >= arg);
-      P.n = ((A - arg) >> 7);
-      writeByte(addr, arg);
-      log(opcode_addr, opcode, "DCP:   $%04X <- $%02X\n", addr, arg);
-    } break;
-
-
-    // ISC: INC then SBC
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::ISC) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::ISC));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-      arg += 1;
-      writeByte(addr, arg);
-
-      const uint16_t res_long = A + ~arg + P.c;
-      const uint8_t  result   = res_long;
-      P.c                     = !((res_long >> 8) & 0x01);
-      P.z                     = (result == 0);
-      P.v                     = (A >> 7 != arg >> 7) && (A >> 7 != result >> 7);
-      P.n                     = (result >> 7);
-      A                       = result;
-      log(opcode_addr, opcode, "ISC:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
-    } break;
-
-
-    // RLA: ROL then AND
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::RLA) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::RLA));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      const bool old_carry = (arg >> 7);
-      arg                  = (arg << 1) | P.c;
-      P.c                  = old_carry;
-      writeByte(addr, arg);
-
-      A &= arg;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "RLA:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
-    } break;
-
-
-    // RRA: ROR then ADC
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::RRA) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::RRA));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      const bool old_carry = (arg & 0x01);
-      arg                  = (arg >> 1) | (P.c << 7);
-      writeByte(addr, arg);
-
-      const uint8_t result = A + arg + old_carry;
-      P.c                  = ((A + arg + old_carry) >> 8) & 0x01;
-      P.z                  = (result == 0);
-      P.v                  = (A >> 7 == arg >> 7) && (A >> 7 != result >> 7);
-      P.n                  = (result >> 7);
-      A                    = result;
-      log(opcode_addr, opcode, "RRA:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
-    } break;
-
-
-    // SLO: ASL then ORA
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::SLO) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::SLO));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
-
-      P.c = (arg >> 7);
-      arg <<= 1;
-      writeByte(addr, arg);
-
-      A |= arg;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "SLO:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
-    } break;
-
-
-    // SRE: LSR then EOR
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::absolute)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::absolute_y)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::indirect_x)):
-    case (asInt(UnofficialInstruction::SRE) + asInt(AddressingMode::indirect_y)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint16_t addr = getArgAddr(opcode - asInt(UnofficialInstruction::SRE));
-      uint8_t        arg  = readByte(addr);
-      writeByte(addr, arg);  // Double write (For absolute addressing)
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::loadState(state::Reader* in) {
+  in->get(PC);
+  in->get(SP);
+  in->get(A);
+  in->get(X);
+  in->get(Y);
+  in->get(P.raw);
+  in->get(prev_nmi_);
+  in->get(irq_reset_);
+  in->get(irq_brk_);
+  in->get(do_poll_interrupts_);
+  in->get(do_nmi_);
+  in->get(do_irq_);
+  in->get(reset_ready_);
+}
 
-      P.c = (arg & 0x01);
-      arg >>= 1;
-      writeByte(addr, arg);
 
-      A ^= arg;
-      P.z = (A == 0);
-      P.n = (A >> 7);
-      log(opcode_addr, opcode, "SRE:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
-    } break;
+// =*=*=*=*= Opcode Dispatch =*=*=*=*=
 
+template <class MapperT>
+const std::array<typename hw::cpu::CPU<MapperT>::Handler, 256> hw::cpu::CPU<MapperT>::HANDLERS[2] = {
+    makeHandlers<false>(std::make_index_sequence<256>()),
+    makeHandlers<true>(std::make_index_sequence<256>()),
+};
 
-    // Subtract with carry
-    case (asInt(UnofficialInstruction::SBC) + asInt(AddressingMode::immediate)): {
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      const uint8_t  arg      = readByte(getArgAddr(AddressingMode::immediate));
-      const uint16_t res_long = A + ~arg + P.c;
-      const uint8_t  result   = res_long;
-      P.c                     = !((res_long >> 8) & 0x01);
-      P.z                     = (result == 0);
-      P.v                     = (A >> 7 != arg >> 7) && (A >> 7 != result >> 7);
-      P.n                     = (result >> 7);
-      A                       = result;
-      log(opcode_addr, opcode, "SBC:       A <- $%02X\n", A);
-    } break;
-
-
-    // No OPeration
-    case (asInt(UnofficialInstruction::NOP_1) + asInt(AddressingMode::implied)):
-    case (asInt(UnofficialInstruction::NOP_2) + asInt(AddressingMode::implied)):
-    case (asInt(UnofficialInstruction::NOP_3) + asInt(AddressingMode::implied)):
-    case (asInt(UnofficialInstruction::NOP_4) + asInt(AddressingMode::implied)):
-    case (asInt(UnofficialInstruction::NOP_5) + asInt(AddressingMode::implied)):
-    case (asInt(UnofficialInstruction::NOP_6) + asInt(AddressingMode::implied)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(PC);  // Dummy read (For one-byte opcodes)
-      log(opcode_addr, opcode, "NOP\n");
-      break;
-
-
-    // Skip Next Byte
-    case (asInt(UnofficialInstruction::SKB_1) + asInt(AddressingMode::immediate)):
-    case (asInt(UnofficialInstruction::SKB_2) + asInt(AddressingMode::immediate)):
-    case (asInt(UnofficialInstruction::SKB_3) + asInt(AddressingMode::immediate)):
-    case (asInt(UnofficialInstruction::SKB_4) + asInt(AddressingMode::immediate)):
-    case (asInt(UnofficialInstruction::SKB_5) + asInt(AddressingMode::immediate)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(getArgAddr(AddressingMode::immediate));
-      log(opcode_addr, opcode, "SKB\n");
-      break;
+template <class MapperT>
+template <bool AllowUnofficial, std::size_t... Codes>
+constexpr std::array<typename hw::cpu::CPU<MapperT>::Handler, 256>
+hw::cpu::CPU<MapperT>::makeHandlers(std::index_sequence<Codes...>) {
+  return {makeHandler<AllowUnofficial, Codes>()...};
+}
 
+template <class MapperT>
+template <bool AllowUnofficial, std::size_t Code>
+constexpr typename hw::cpu::CPU<MapperT>::Handler hw::cpu::CPU<MapperT>::makeHandler() {
+  constexpr Opcode OPCODE = OPCODES[Code];
+  if constexpr (OPCODE.operation == Operation::ILL || !(OPCODE.official || AllowUnofficial)) {
+    return &CPU::illegal;
+  } else {
+    return &CPU::execute<OPCODE.operation, OPCODE.mode>;
+  }
+}
 
-    // IGNore
-    case (asInt(UnofficialInstruction::IGN_1) + asInt(AddressingMode::absolute)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(getArgAddr(AddressingMode::absolute));
-      log(opcode_addr, opcode, "IGN");
-      break;
-    case (asInt(UnofficialInstruction::IGN_1) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::IGN_2) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::IGN_3) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::IGN_4) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::IGN_5) + asInt(AddressingMode::absolute_x)):
-    case (asInt(UnofficialInstruction::IGN_6) + asInt(AddressingMode::absolute_x)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(getArgAddr(AddressingMode::absolute_x, true));
-      log(opcode_addr, opcode, "IGN");
-      break;
-    case (asInt(UnofficialInstruction::IGN_1) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::IGN_3) + asInt(AddressingMode::zero_page)):
-    case (asInt(UnofficialInstruction::IGN_4) + asInt(AddressingMode::zero_page)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(getArgAddr(AddressingMode::zero_page));
-      log(opcode_addr, opcode, "IGN");
-      break;
-    case (asInt(UnofficialInstruction::IGN_1) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::IGN_2) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::IGN_3) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::IGN_4) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::IGN_5) + asInt(AddressingMode::zero_page_x)):
-    case (asInt(UnofficialInstruction::IGN_6) + asInt(AddressingMode::zero_page_x)):
-      if (!allow_unofficial_) {
-        goto illegal_instruction;
-      }
-      readByte(getArgAddr(AddressingMode::zero_page_x));
-      log(opcode_addr, opcode, "IGN");
-      break;
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::illegal(uint16_t opcode_addr, uint8_t opcode) {
+  logger::log<logger::ERROR>("Illegal instruction $%02X at address $%04X\n", opcode, opcode_addr);
+  reset(true);
+}
+
+template <class MapperT>
+const typename hw::cpu::CPU<MapperT>::Decoded* hw::cpu::CPU<MapperT>::decode(uint16_t address) {
+
+  // Only PRG ROM can be cached, and only if the whole instruction is in the same 8KiB bank
+  if (address < 0x8000 || (address & 0x1FFF) > 0x2000 - sizeof(Decoded::bytes)) {
+    return nullptr;
+  }
+
+  const uint8_t*    instruction = bus_->peek(address);
+  const std::size_t offset      = instruction - prg_rom_;
+  if (offset >= decoded_.size()) {
+    return nullptr;
+  }
+
+  Decoded& decoded = decoded_[offset];
+  if (!decoded.handler) {
+    const uint8_t opcode = instruction[0];
+    for (unsigned i = 0; i < OPCODES[opcode].length; i++) {
+      decoded.bytes[i] = instruction[i];
+    }
+    decoded.handler = HANDLERS[allow_unofficial_][opcode];
+  }
+  return &decoded;
+}
+
+template <class MapperT>
+const typename hw::cpu::CPU<MapperT>::Block* hw::cpu::CPU<MapperT>::translate(uint16_t address) {
+  const Decoded* first = decode(address);
+  if (!first) {
+    return nullptr;
+  }
 
+  const auto [it, is_new] = blocks_.try_emplace(first - decoded_.data());
+  Block& block            = it->second;
+  if (is_new) {
+    uint16_t       pc      = address;
+    const Decoded* decoded = first;
+    while (decoded) {
+      block.instructions.push_back(decoded);
+
+      const Opcode& opcode = OPCODES[decoded->bytes[0]];
+      if (endsBlock(opcode.operation) || ((pc + opcode.length) & 0xE000) != (address & 0xE000)) {
+        break;
+      }
+      pc += opcode.length;
+      decoded = decode(pc);
+    }
+    findIdleLoop(&block, address);
+  }
+  return &block;
+}
 
-    // Illegal instruction
-    illegal_instruction:
+template <class MapperT>
+constexpr bool hw::cpu::CPU<MapperT>::endsBlock(Operation op) {
+  switch (op) {
+    case Operation::BPL:
+    case Operation::BMI:
+    case Operation::BVC:
+    case Operation::BVS:
+    case Operation::BCC:
+    case Operation::BCS:
+    case Operation::BNE:
+    case Operation::BEQ:
+    case Operation::BRK:
+    case Operation::JMP:
+    case Operation::JSR:
+    case Operation::RTI:
+    case Operation::RTS:
+    case Operation::ILL:
+      return true;
     default:
-      logger::log<logger::ERROR>("Illegal instruction $%02X at address $%04X\n", opcode, PC - 1);
-      reset(true);
-      break;
+      return false;
   }
+}
 
-#if DEBUG
-  if (std::cin.fail()) {
-    std::cin.clear();
-    std::cin.ignore();
-    next_op = PC;
+template <class MapperT>
+template <hw::cpu::Operation Op, hw::cpu::AddressingMode Mode>
+void hw::cpu::CPU<MapperT>::execute(uint16_t opcode_addr, uint8_t opcode) {
+  using M = AddressingMode;
+
+  // =*=*=*=*= Official Opcodes =*=*=*=*=
+
+  // Add with carry
+  if constexpr (Op == Operation::ADC) {
+    const uint8_t arg    = readArg<Mode, true>();
+    const uint8_t result = A + arg + P.c;
+    P.c                  = ((A + arg + P.c) >> 8) & 0x01;
+    P.z                  = (result == 0);
+    P.v                  = (A >> 7 == arg >> 7) && (A >> 7 != result >> 7);
+    P.n                  = (result >> 7);
+    A                    = result;
+    log(opcode_addr, opcode, "ADC:       A <- $%02X\n", A);
+  }
+
+
+  // Bitwise AND with accumulator
+  else if constexpr (Op == Operation::AND) {
+    A &= readArg<Mode, true>();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "AND:       A <- $%02X\n", A);
+  }
+
+
+  // Arithmetic shift left
+  else if constexpr (Op == Operation::ASL && Mode == M::accumulator) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.c = (A >> 7);
+    A <<= 1;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "ASL:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::ASL) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    P.c = (arg >> 7);
+    arg <<= 1;
+    P.z = (arg == 0);
+    P.n = (arg >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "ASL:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // Test bits
+  else if constexpr (Op == Operation::BIT) {
+    const uint8_t arg = readArg<Mode>();
+    P.z               = ((A & arg) == 0);
+    P.v               = (arg >> 6) & 0x01;
+    P.n               = (arg >> 7);
+    log(opcode_addr, opcode, "BIT:     $%02X\n", arg);
+  }
+
+
+  // Branch
+  else if constexpr (Op == Operation::BPL) {
+    branch(!P.n);
+    log(opcode_addr, opcode, "BPL\n");
+  } else if constexpr (Op == Operation::BMI) {
+    branch(P.n);
+    log(opcode_addr, opcode, "BMI\n");
+  } else if constexpr (Op == Operation::BVC) {
+    branch(!P.v);
+    log(opcode_addr, opcode, "BVC\n");
+  } else if constexpr (Op == Operation::BVS) {
+    branch(P.v);
+    log(opcode_addr, opcode, "BVS\n");
+  } else if constexpr (Op == Operation::BCC) {
+    branch(!P.c);
+    log(opcode_addr, opcode, "BCC\n");
+  } else if constexpr (Op == Operation::BCS) {
+    branch(P.c);
+    log(opcode_addr, opcode, "BCS\n");
+  } else if constexpr (Op == Operation::BNE) {
+    branch(!P.z);
+    log(opcode_addr, opcode, "BNE\n");
+  } else if constexpr (Op == Operation::BEQ) {
+    branch(P.z);
+    log(opcode_addr, opcode, "BEQ\n");
+  }
+
+
+  // Break
+  else if constexpr (Op == Operation::BRK) {
+    fetch();  // Padding byte
+
+    P.b = 0b11;
+    push(PC >> 8);
+    push(PC);
+
+    irq_brk_ = true;
+    log(opcode_addr, opcode, "BRK\n");
+  }
+
+
+  // Compare accumulator
+  else if constexpr (Op == Operation::CMP) {
+    const uint8_t arg = readArg<Mode, true>();
+    P.z               = (A == arg);
+    P.c               = (A >= arg);
+    P.n               = ((A - arg) >> 7);
+    log(opcode_addr, opcode, "CMP:     $%02X\n", arg);
+  }
+
+
+  // Compare X register
+  else if constexpr (Op == Operation::CPX) {
+    const uint8_t arg = readArg<Mode>();
+    P.z               = (X == arg);
+    P.c               = (X >= arg);
+    P.n               = ((X - arg) >> 7);
+    log(opcode_addr, opcode, "CPX:     $%02X\n", arg);
+  }
+
+
+  // Compare Y register
+  else if constexpr (Op == Operation::CPY) {
+    const uint8_t arg = readArg<Mode>();
+    P.z               = (Y == arg);
+    P.c               = (Y >= arg);
+    P.n               = ((Y - arg) >> 7);
+    log(opcode_addr, opcode, "CPY:     $%02X\n", arg);
+  }
+
+
+  // Decrement memory
+  else if constexpr (Op == Operation::DEC) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    arg -= 1;
+    P.z = (arg == 0);
+    P.n = (arg >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "DEC:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // Bitwise exclusive OR
+  else if constexpr (Op == Operation::EOR) {
+    A ^= readArg<Mode, true>();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "EOR:       A <- $%02X\n", A);
+  }
+
+
+  // Flag (Processor Status) manipulation
+  else if constexpr (Op == Operation::CLC) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.c = false;
+    log(opcode_addr, opcode, "CLC\n");
+  } else if constexpr (Op == Operation::SEC) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.c = true;
+    log(opcode_addr, opcode, "SEC\n");
+  } else if constexpr (Op == Operation::CLI) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.i = false;
+    log(opcode_addr, opcode, "CLI\n");
+  } else if constexpr (Op == Operation::SEI) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.i = true;
+    log(opcode_addr, opcode, "SEI\n");
+  } else if constexpr (Op == Operation::CLV) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.v = false;
+    log(opcode_addr, opcode, "CLV\n");
+  } else if constexpr (Op == Operation::CLD) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.d = false;
+    log(opcode_addr, opcode, "CLD\n");
+  } else if constexpr (Op == Operation::SED) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.d = true;
+    log(opcode_addr, opcode, "SED\n");
+  }
+
+
+  // Increment memory
+  else if constexpr (Op == Operation::INC) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    arg += 1;
+    P.z = (arg == 0);
+    P.n = (arg >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "INC:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // Jump
+  else if constexpr (Op == Operation::JMP && Mode == M::absolute) {
+    PC = getArgAddr<M::absolute>();
+    log(opcode_addr, opcode, "JMP:   $%04X\n", PC);
+  } else if constexpr (Op == Operation::JMP) {  // Like indirect, but with page wrap bug
+    uint16_t addr = fetch();
+    addr |= (fetch() << 8);
+    const uint16_t page = addr & 0xFF00;
+    PC                  = readByte(addr) | (readByte(((addr + 1) & 0x00FF) | page) << 8);
+    log(opcode_addr, opcode, "JMP:   $%04X\n", PC);
+  }
+
+
+  // Jump to service routine
+  else if constexpr (Op == Operation::JSR) {
+    const uint16_t address = getArgAddr<M::absolute>();
+    tick();  // Unknown extra cycle (Pre-decrement S?)
+    push((PC - 1) >> 8);
+    push(PC - 1);
+    PC = address;
+    log(opcode_addr, opcode, "JSR:   $%04X\n", PC);
+  }
+
+
+  // Load accumulator
+  else if constexpr (Op == Operation::LDA) {
+    A   = readArg<Mode, true>();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "LDA:       A <- $%02X\n", A);
+  }
+
+
+  // Load X register
+  else if constexpr (Op == Operation::LDX) {
+    X   = readArg<Mode, true>();
+    P.z = (X == 0);
+    P.n = (X >> 7);
+    log(opcode_addr, opcode, "LDX:       X <- $%02X\n", X);
+  }
+
+
+  // Load Y register
+  else if constexpr (Op == Operation::LDY) {
+    Y   = readArg<Mode, true>();
+    P.z = (Y == 0);
+    P.n = (Y >> 7);
+    log(opcode_addr, opcode, "LDY:       Y <- $%02X\n", Y);
+  }
+
+
+  // Logical shift right
+  else if constexpr (Op == Operation::LSR && Mode == M::accumulator) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.c = (A & 0x01);
+    A >>= 1;
+    P.z = (A == 0);
+    P.n = (A >> 7);  // Always 0
+    log(opcode_addr, opcode, "LSR:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::LSR) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    P.c = (arg & 0x01);
+    arg >>= 1;
+    P.z = (arg == 0);
+    P.n = (arg >> 7);  // Always 0
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "LSR:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // No operation. The unofficial SKB and IGN variants read their operand
+  else if constexpr (Op == Operation::NOP && Mode == M::implied) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    log(opcode_addr, opcode, "NOP\n");
+  } else if constexpr (Op == Operation::NOP) {
+    readArg<Mode, true>();
+    log(opcode_addr, opcode, "NOP\n");
+  }
+
+
+  // Logical inclusive OR
+  else if constexpr (Op == Operation::ORA) {
+    A |= readArg<Mode, true>();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "ORA:       A <- $%02X\n", A);
+  }
+
+
+  // Register manipulation
+  else if constexpr (Op == Operation::TAX) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    X   = A;
+    P.z = (X == 0);
+    P.n = (X >> 7);
+    log(opcode_addr, opcode, "TAX:       X <- $%02X\n", X);
+  } else if constexpr (Op == Operation::TXA) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    A   = X;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "TXA:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::DEX) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    X--;
+    P.z = (X == 0);
+    P.n = (X >> 7);
+    log(opcode_addr, opcode, "DEX:       X <- $%02X\n", X);
+  } else if constexpr (Op == Operation::INX) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    X++;
+    P.z = (X == 0);
+    P.n = (X >> 7);
+    log(opcode_addr, opcode, "INX:       X <- $%02X\n", X);
+  } else if constexpr (Op == Operation::TAY) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    Y   = A;
+    P.z = (Y == 0);
+    P.n = (Y >> 7);
+    log(opcode_addr, opcode, "TAY:       Y <- $%02X\n", Y);
+  } else if constexpr (Op == Operation::TYA) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    A   = Y;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "TYA:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::DEY) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    Y--;
+    P.z = (Y == 0);
+    P.n = (Y >> 7);
+    log(opcode_addr, opcode, "DEY:       Y <- $%02X\n", Y);
+  } else if constexpr (Op == Operation::INY) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    Y++;
+    P.z = (Y == 0);
+    P.n = (Y >> 7);
+    log(opcode_addr, opcode, "INY:       Y <- $%02X\n", Y);
+  }
+
+
+  // Rotate left
+  else if constexpr (Op == Operation::ROL && Mode == M::accumulator) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    const bool old_carry = (A >> 7);
+    A                    = (A << 1) | P.c;
+    P.c                  = old_carry;
+    P.z                  = (A == 0);
+    P.n                  = (A >> 7);
+    log(opcode_addr, opcode, "ROL:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::ROL) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    const bool old_carry = (arg >> 7);
+    arg                  = (arg << 1) | P.c;
+    P.c                  = old_carry;
+    P.z                  = (arg == 0);
+    P.n                  = (arg >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "ROL:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // Rotate right
+  else if constexpr (Op == Operation::ROR && Mode == M::accumulator) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    const bool old_carry = (A & 0x01);
+    A                    = (A >> 1) | (P.c << 7);
+    P.c                  = old_carry;
+    P.z                  = (A == 0);
+    P.n                  = (A >> 7);
+    log(opcode_addr, opcode, "ROR:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::ROR) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    const bool old_carry = (arg & 0x01);
+    arg                  = (arg >> 1) | (P.c << 7);
+    P.c                  = old_carry;
+    P.z                  = (arg == 0);
+    P.n                  = (arg >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "ROR:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // Return from interrupt
+  else if constexpr (Op == Operation::RTI) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    tick();        // Increment stack pointer
+    P.raw = pop() & 0xCF;
+    PC    = pop() | pop() << 8;
+    log(opcode_addr, opcode, "RTI:   $%04X\n", PC);
+  }
+
+
+  // Return from subroutine
+  else if constexpr (Op == Operation::RTS) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    tick();        // Increment stack pointer
+    PC = (pop() | pop() << 8) + 1;
+    tick();  // Increment PC
+    log(opcode_addr, opcode, "RTS:   $%04X\n", PC);
+  }
+
+
+  // Subtract with carry
+  else if constexpr (Op == Operation::SBC) {
+    const uint8_t  arg      = readArg<Mode, true>();
+    const uint16_t res_long = A + ~arg + P.c;
+    const uint8_t  result   = res_long;
+    P.c                     = !((res_long >> 8) & 0x01);
+    P.z                     = (result == 0);
+    P.v                     = (A >> 7 != arg >> 7) && (A >> 7 != result >> 7);
+    P.n                     = (result >> 7);
+    A                       = result;
+    log(opcode_addr, opcode, "SBC:       A <- $%02X\n", A);
+  }
+
+
+  // Store accumulator
+  else if constexpr (Op == Operation::STA) {
+    const uint16_t addr = getArgAddr<Mode>();
+    writeByte(addr, A);
+    log(opcode_addr, opcode, "STA:   $%04X <- $%02X\n", addr, A);
+  }
+
+
+  // Stack manipulation
+  else if constexpr (Op == Operation::TXS) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    SP = X;
+    log(opcode_addr, opcode, "TXS:      SP <- $%02X\n", SP);
+  } else if constexpr (Op == Operation::TSX) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    X   = SP;
+    P.z = (X == 0);
+    P.n = (X >> 7);
+    log(opcode_addr, opcode, "TSX:       X <- $%02X\n", X);
+  } else if constexpr (Op == Operation::PHA) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    push(A);
+    log(opcode_addr, opcode, "PHA:      SP <- $%02X\n", A);
+  } else if constexpr (Op == Operation::PLA) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    tick();        // Increment stack pointer
+    A   = pop();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "PLA:       A <- $%02X\n", A);
+  } else if constexpr (Op == Operation::PHP) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    P.b = 0b11;
+    push(P.raw);
+    P.b = 0;
+    log(opcode_addr, opcode, "PHP:      SP <- $%02X\n", P.raw);
+  } else if constexpr (Op == Operation::PLP) {
+    readByte(PC);  // Dummy read (For one-byte opcodes)
+    tick();        // Increment stack pointer
+    P.raw = pop() & 0xCF;
+    log(opcode_addr, opcode, "PLP:       P <- $%02X\n", P.raw);
+  }
+
+
+  // Store X register
+  else if constexpr (Op == Operation::STX) {
+    const uint16_t addr = getArgAddr<Mode>();
+    writeByte(addr, X);
+    log(opcode_addr, opcode, "STX:   $%04X <- $%02X\n", addr, X);
+  }
+
+
+  // Store Y register
+  else if constexpr (Op == Operation::STY) {
+    const uint16_t addr = getArgAddr<Mode>();
+    writeByte(addr, Y);
+    log(opcode_addr, opcode, "STY:   $%04X <- $%02X\n", addr, Y);
+  }
+
+
+  // =*=*=*=*= Unofficial Opcodes =*=*=*=*=
+
+  // ALR: AND #i then LSR A
+  else if constexpr (Op == Operation::ALR) {
+    A &= readArg<Mode>();
+    P.c = (A & 0x01);
+    A >>= 1;
+    P.z = (A == 0);
+    P.n = (A >> 7);  // Always 0
+    log(opcode_addr, opcode, "ALR:       A <- $%02X\n", A);
+  }
+
+
+  // ANC: AND #i then C<-N
+  else if constexpr (Op == Operation::ANC) {
+    A &= readArg<Mode>();
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    P.c = P.n;
+    log(opcode_addr, opcode, "ANC:       A <- $%02X\n", A);
+  }
+
+
+  // ARR: AND #i then ROR A, but with different flags
+  else if constexpr (Op == Operation::ARR) {
+    A &= readArg<Mode>();
+    A   = (A >> 1) | (P.c << 7);
+    P.c = (A >> 6) & 0x01;
+    P.z = (A == 0);
+    P.v = P.c ^ ((A >> 5) & 0x01);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "ARR:       A <- $%02X\n", A);
+  }
+
+
+  // LAX: LDA then TAX
+  else if constexpr (Op == Operation::LAX) {
+    A   = readArg<Mode, true>();
+    X   = A;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "LAX:       A <- $%02X\n", A);
+  }
+
+
+  // SAX: Store A & X
+  else if constexpr (Op == Operation::SAX) {
+    const uint16_t addr = getArgAddr<Mode>();
+    writeByte(addr, A & X);
+    log(opcode_addr, opcode, "SAX:   $%04X <- $%02X\n", addr, A & X);
+  }
+
+
+  // DCP: DEC then CMP
+  else if constexpr (Op == Operation::DCP) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    arg -= 1;
+    P.z = (A == arg);
+    P.c = (A >= arg);
+    P.n = ((A - arg) >> 7);
+    writeByte(addr, arg);
+    log(opcode_addr, opcode, "DCP:   $%04X <- $%02X\n", addr, arg);
+  }
+
+
+  // ISC: INC then SBC
+  else if constexpr (Op == Operation::ISC) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+    arg += 1;
+    writeByte(addr, arg);
+
+    const uint16_t res_long = A + ~arg + P.c;
+    const uint8_t  result   = res_long;
+    P.c                     = !((res_long >> 8) & 0x01);
+    P.z                     = (result == 0);
+    P.v                     = (A >> 7 != arg >> 7) && (A >> 7 != result >> 7);
+    P.n                     = (result >> 7);
+    A                       = result;
+    log(opcode_addr, opcode, "ISC:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
+  }
+
+
+  // RLA: ROL then AND
+  else if constexpr (Op == Operation::RLA) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    const bool old_carry = (arg >> 7);
+    arg                  = (arg << 1) | P.c;
+    P.c                  = old_carry;
+    writeByte(addr, arg);
+
+    A &= arg;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "RLA:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
+  }
+
+
+  // RRA: ROR then ADC
+  else if constexpr (Op == Operation::RRA) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    const bool old_carry = (arg & 0x01);
+    arg                  = (arg >> 1) | (P.c << 7);
+    writeByte(addr, arg);
+
+    const uint8_t result = A + arg + old_carry;
+    P.c                  = ((A + arg + old_carry) >> 8) & 0x01;
+    P.z                  = (result == 0);
+    P.v                  = (A >> 7 == arg >> 7) && (A >> 7 != result >> 7);
+    P.n                  = (result >> 7);
+    A                    = result;
+    log(opcode_addr, opcode, "RRA:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
+  }
+
+
+  // SLO: ASL then ORA
+  else if constexpr (Op == Operation::SLO) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    P.c = (arg >> 7);
+    arg <<= 1;
+    writeByte(addr, arg);
+
+    A |= arg;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "SLO:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
+  }
+
+
+  // SRE: LSR then EOR
+  else if constexpr (Op == Operation::SRE) {
+    const uint16_t addr = getArgAddr<Mode>();
+    uint8_t        arg  = readByte(addr);
+    writeByte(addr, arg);  // Double write (For absolute addressing)
+
+    P.c = (arg & 0x01);
+    arg >>= 1;
+    writeByte(addr, arg);
+
+    A ^= arg;
+    P.z = (A == 0);
+    P.n = (A >> 7);
+    log(opcode_addr, opcode, "SRE:   $%04X <- $%02X, A <- $%02X\n", addr, arg, A);
+  }
+
+
+  // Every operation in OPCODES must be handled above
+  else {
+    static_assert(Op != Op, "Unhandled operation");
   }
-#endif
 }
 
-void hw::cpu::CPU::reset(bool active) {
-  irq_reset_ = active;
-  if (!irq_reset_) {
-    reset_ready_ = false;
+
+// =*=*=*=*= Idle Loops =*=*=*=*=
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::findIdleLoop(Block* block, uint16_t address) {
+  using M = AddressingMode;
+
+  if (block->instructions.size() > MAX_IDLE_LOOP_LENGTH) {
+    return;
+  }
+
+  bool     reads_status = false;
+  uint16_t pc           = address;
+  for (const Decoded* decoded : block->instructions) {
+    const Opcode&  opcode  = OPCODES[decoded->bytes[0]];
+    const uint16_t operand = decoded->bytes[1] | (decoded->bytes[2] << 8);
+    if (!opcode.official) {
+      return;
+    }
+
+    switch (opcode.operation) {
+
+      // The block ends with the branch or jump, which must go back to its start
+      case Operation::BPL:
+      case Operation::BMI:
+      case Operation::BVC:
+      case Operation::BVS:
+      case Operation::BCC:
+      case Operation::BCS:
+      case Operation::BNE:
+      case Operation::BEQ:
+        block->idle         = uint16_t(pc + opcode.length + int8_t(decoded->bytes[1])) == address;
+        block->reads_status = block->idle && reads_status;
+        return;
+      case Operation::JMP:
+        block->idle         = opcode.mode == M::absolute && operand == address;
+        block->reads_status = block->idle && reads_status;
+        return;
+
+      // Only depend on memory and the registers, and only change the registers
+      case Operation::LDA:
+      case Operation::LDX:
+      case Operation::LDY:
+      case Operation::BIT:
+      case Operation::CMP:
+      case Operation::CPX:
+      case Operation::CPY:
+      case Operation::AND:
+      case Operation::ORA:
+      case Operation::NOP:
+      case Operation::TAX:
+      case Operation::TAY:
+      case Operation::TXA:
+      case Operation::TYA:
+      case Operation::TSX:
+      case Operation::CLC:
+      case Operation::SEC:
+      case Operation::CLV:
+      case Operation::CLD:
+      case Operation::SED:
+        break;
+      default:
+        return;
+    }
+
+    // Only RAM and PRG ROM, which nothing but the CPU can change, or PPUSTATUS, which the PPU can predict for a while
+    switch (opcode.mode) {
+      case M::implied:
+      case M::accumulator:
+      case M::immediate:
+      case M::zero_page:
+      case M::zero_page_x:
+      case M::zero_page_y:
+        break;
+      case M::absolute:
+        if ((operand & 0xE007) == utils::asInt(ppu::MemoryMappedIO::PPUSTATUS)) {
+          reads_status = true;
+        } else if (0x2000 <= operand && operand < 0x8000) {
+          return;
+        }
+        break;
+      default:
+        return;
+    }
+
+    pc += opcode.length;
   }
 }
 
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::skipIdleLoop() {
+  const Block* block = hasInterrupt() ? nullptr : translate(PC);
+  if (!block || !block->idle) {
+    return;
+  }
+
+  // PPUSTATUS must not change from the first iteration to the last
+  uint64_t max_cycles = block->reads_status ? bus_->statusStableCycles() : UINT64_MAX;
+
+  // Run one iteration, recording the registers, the last value read and the cycles taken after each instruction
+  struct Step {
+    Registers registers;
+    uint8_t   open_bus;
+    uint64_t  cycles;
+  };
+  Step              steps[MAX_IDLE_LOOP_LENGTH];
+  const Registers   start  = registers();
+  const uint64_t    cycles = bus_->cycles();
+  const std::size_t length = block->instructions.size();
+  for (std::size_t i = 0; i < length; i++) {
+    const uint64_t step_start = bus_->cycles();
+    executeDecoded(block->instructions[i]);
+    steps[i] = {registers(), bus_->openBus(), bus_->cycles() - step_start};
+    if (hasInterrupt()) {
+      return;
+    }
+  }
+
+  // If the iteration left the registers as it found them, every iteration after it will be the same. Unless an
+  // interrupt was detected on its last cycle, which is only serviced after the next instruction
+  if (registers() != start || bus_->cycles() - cycles >= max_cycles || do_nmi_[0] || do_irq_[0]) {
+    return;
+  }
+  const uint64_t period = bus_->cycles() - cycles;
+  max_cycles            = std::min(max_cycles - period, MAX_IDLE_SKIP);
+
+  // Skip an event at a time. The iterations which end before the next event leave the registers, the last value read
+  // and the interrupt lines as they are, so are skipped at once. The iteration the event lands in is replayed, stopping
+  // between instructions as soon as there is an interrupt to service
+  uint64_t skipped = 0;
+  for (bool idle = true; idle;) {
+    const uint64_t until_event = std::min(bus_->cyclesUntilEvent(), max_cycles - skipped);
+    const uint64_t iterations  = until_event > period ? (until_event - 1) / period : 0;
+    bus_->skip(static_cast<uint32_t>(iterations * period));
+    skipped += iterations * period;
+
+    for (std::size_t i = 0; i < length && idle; i++) {
+      idle = skipped + steps[i].cycles <= max_cycles;
+      if (!idle) {
+        break;
+      }
+      for (uint64_t cycle = 0; cycle < steps[i].cycles; cycle++) {
+        tick();
+      }
+      skipped += steps[i].cycles;
+      setRegisters(steps[i].registers);
+      bus_->setOpenBus(steps[i].open_bus);
+      idle = !hasInterrupt();
+    }
+    idle = idle && !do_nmi_[0] && !do_irq_[0];
+  }
+
+  skipped_cycles_ += skipped;
+  logger::log<logger::DEBUG_CPU>(
+      "Skipped %llu cycles of idle loop at $%04X\n", static_cast<unsigned long long>(skipped), start.pc);
+}
+
 
 // =*=*=*=*= CPU Internal Operations =*=*=*=*=
 
-uint8_t hw::cpu::CPU::readByte(uint16_t address) {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::executeDecoded(const Decoded* decoded) {
+  const uint16_t opcode_addr = PC;
+  operands_                  = decoded->bytes;
+  const uint8_t opcode       = fetch();
+  (this->*decoded->handler)(opcode_addr, opcode);
+  operands_ = nullptr;
+}
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::setRegisters(const Registers& registers) {
+  PC    = registers.pc;
+  SP    = registers.sp;
+  A     = registers.a;
+  X     = registers.x;
+  Y     = registers.y;
+  P.raw = registers.p;
+}
+
+template <class MapperT>
+uint8_t hw::cpu::CPU<MapperT>::readByte(uint16_t address) {
   tick();
   return bus_->read(address);
 }
 
-void hw::cpu::CPU::writeByte(uint16_t address, uint8_t data) {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::writeByte(uint16_t address, uint8_t data) {
   tick();
 
   // Writes are prohibited during reset, reads performed instead
@@ -1077,15 +1116,29 @@ void hw::cpu::CPU::writeByte(uint16_t address, uint8_t data) {
   }
 }
 
-void hw::cpu::CPU::push(uint8_t data) {
+template <class MapperT>
+uint8_t hw::cpu::CPU<MapperT>::fetch() {
+  if (!operands_) {
+    return readByte(PC++);
+  }
+
+  // Already decoded, so skip the memory map. The bus still sees the read
+  tick();
+  return bus_->readKnown(PC++, *operands_++);
+}
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::push(uint8_t data) {
   writeByte(0x0100 + SP--, data);
 }
 
-uint8_t hw::cpu::CPU::pop() {
+template <class MapperT>
+uint8_t hw::cpu::CPU<MapperT>::pop() {
   return readByte(0x0100 + (++SP));
 }
 
-void hw::cpu::CPU::tick(int ticks) {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::tick(int ticks) {
   // TODO: DMA stalls
   for (; ticks > 0; ticks--) {
     bus_->clock();
@@ -1096,26 +1149,33 @@ void hw::cpu::CPU::tick(int ticks) {
   pollInterrupt();
 }
 
-void hw::cpu::CPU::pollInterrupt() {
+template <class MapperT>
+bool hw::cpu::CPU<MapperT>::hasInterrupt() const {
+  return irq_reset_ || do_nmi_[1] || irq_brk_ || do_irq_[1];
+}
+
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::pollInterrupt() {
   if (!do_poll_interrupts_) {
     return;
   }
 
-  static bool prev_nmi = false;
-  const bool  cur_nmi  = bus_->hasNMI();
+  const bool cur_nmi = bus_->hasNMI();
 
   do_nmi_[1] = do_nmi_[0];
   do_irq_[1] = do_irq_[0];
-  do_nmi_[0] |= (!prev_nmi && cur_nmi);
+  do_nmi_[0] |= (!prev_nmi_ && cur_nmi);
   do_irq_[0] = bus_->hasIRQ() && !P.i;
 
-  prev_nmi = cur_nmi;
+  prev_nmi_ = cur_nmi;
 }
 
-void hw::cpu::CPU::interrupt() {
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::interrupt() {
 
-  // While reset is held, only handle the IRQ once
+  // While reset is held, only handle the IRQ once. The CPU is halted, but its clock still drives the other chips
   if (irq_reset_ && reset_ready_) {
+    tick();
     return;
   }
 
@@ -1160,8 +1220,9 @@ void hw::cpu::CPU::interrupt() {
   logger::log<logger::DEBUG_CPU>("Interrupt, jumping to $%04X\n", vector);
 }
 
-void hw::cpu::CPU::branch(bool condition) {
-  const uint8_t val    = readByte(getArgAddr(AddressingMode::relative));
+template <class MapperT>
+void hw::cpu::CPU<MapperT>::branch(bool condition) {
+  const uint8_t val    = fetch();
   const int8_t  offset = (val & 0xF0) ? -uint8_t(~val + 1) : val;
   if (condition) {
     const uint8_t PCL = PC & 0xFF;
@@ -1175,86 +1236,86 @@ void hw::cpu::CPU::branch(bool condition) {
   }
 }
 
-uint16_t hw::cpu::CPU::getArgAddr(std::underlying_type_t<AddressingMode> mode, bool dummy_read_optional) {
-  return getArgAddr(utils::asEnum<AddressingMode>(mode), dummy_read_optional);
-}
+template <class MapperT>
+template <hw::cpu::AddressingMode Mode, bool dummy_read_optional>
+uint16_t hw::cpu::CPU<MapperT>::getArgAddr() {
+  using M = AddressingMode;
 
-uint16_t hw::cpu::CPU::getArgAddr(AddressingMode mode, bool dummy_read_optional) {
-  switch (mode) {
-    case (AddressingMode::immediate):  // Or relative
-      return PC++;
+  if constexpr (Mode == M::zero_page) {  // 1 cycles
+    return fetch();
 
-    case (AddressingMode::zero_page):  // 1 cycles
-      return readByte(PC++);
+  } else if constexpr (Mode == M::zero_page_x) {  // 2 cycles
+    const uint8_t addr = fetch();
+    readByte(addr);  // Dummy read
+    return (addr + X) & 0xFF;
 
-    case (AddressingMode::zero_page_x): {  // 2 cycles
-      const uint8_t addr = readByte(PC++);
-      readByte(addr);  // Dummy read
-      return (addr + X) & 0xFF;
-    }
-
-    case (AddressingMode::zero_page_y): {  // 2 cycles
-      const uint8_t addr = readByte(PC++);
-      readByte(addr);  // Dummy read
-      return (addr + Y) & 0xFF;
-    }
+  } else if constexpr (Mode == M::zero_page_y) {  // 2 cycles
+    const uint8_t addr = fetch();
+    readByte(addr);  // Dummy read
+    return (addr + Y) & 0xFF;
 
-    case (AddressingMode::absolute): {  // 2 cycles
-      const uint16_t addr = readByte(PC++);
-      return addr | (readByte(PC++) << 8);
-    }
+  } else if constexpr (Mode == M::absolute) {  // 2 cycles
+    const uint16_t addr = fetch();
+    return addr | (fetch() << 8);
 
-    case (AddressingMode::absolute_x): {  // 2+ cycles
-      const uint8_t low_byte  = readByte(PC++);
-      const uint8_t high_byte = readByte(PC++);
+  } else if constexpr (Mode == M::absolute_x) {  // 2+ cycles
+    const uint8_t low_byte  = fetch();
+    const uint8_t high_byte = fetch();
 
-      // If low byte + X carries, take an extra tick to correct the high byte
-      if (!dummy_read_optional || ((low_byte + X) & 0x0100)) {
-        readByte(((low_byte + X) & 0xFF) | high_byte << 8);  // Dummy read
-      }
-
-      return (low_byte | high_byte << 8) + X;
+    // If low byte + X carries, take an extra tick to correct the high byte
+    if (!dummy_read_optional || ((low_byte + X) & 0x0100)) {
+      readByte(((low_byte + X) & 0xFF) | high_byte << 8);  // Dummy read
     }
 
-    case (AddressingMode::absolute_y): {  // 2+ cycles
-      const uint8_t low_byte  = readByte(PC++);
-      const uint8_t high_byte = readByte(PC++);
+    return (low_byte | high_byte << 8) + X;
 
-      // If low byte + Y carries, take an extra tick to correct the high byte
-      if (!dummy_read_optional || ((low_byte + Y) & 0x0100)) {
-        readByte(((low_byte + Y) & 0xFF) | high_byte << 8);  // Dummy read
-      }
-      return (low_byte | (high_byte << 8)) + Y;
-    }
+  } else if constexpr (Mode == M::absolute_y) {  // 2+ cycles
+    const uint8_t low_byte  = fetch();
+    const uint8_t high_byte = fetch();
 
-    case (AddressingMode::indirect): {  // 4 cycles
-      uint16_t addr = readByte(PC++);
-      addr |= (readByte(PC++) << 8);
-      return readByte(addr) | (readByte(addr + 1) << 8);
+    // If low byte + Y carries, take an extra tick to correct the high byte
+    if (!dummy_read_optional || ((low_byte + Y) & 0x0100)) {
+      readByte(((low_byte + Y) & 0xFF) | high_byte << 8);  // Dummy read
     }
-
-    case (AddressingMode::indirect_x): {  // 4 cycles
-      uint8_t addr = readByte(PC++);
-      readByte(addr);  // Dummy read
-      addr += X;
-      return readByte(addr) | (readByte((addr + 1) & 0xFF) << 8);
+    return (low_byte | (high_byte << 8)) + Y;
+
+  } else if constexpr (Mode == M::indirect) {  // 4 cycles
+    uint16_t addr = fetch();
+    addr |= (fetch() << 8);
+    return readByte(addr) | (readByte(addr + 1) << 8);
+
+  } else if constexpr (Mode == M::indirect_x) {  // 4 cycles
+    uint8_t addr = fetch();
+    readByte(addr);  // Dummy read
+    addr += X;
+    return readByte(addr) | (readByte((addr + 1) & 0xFF) << 8);
+
+  } else if constexpr (Mode == M::indirect_y) {  // 3+ cycles
+    const uint8_t ptr_addr  = fetch();
+    const uint8_t low_byte  = readByte(ptr_addr);
+    const uint8_t high_byte = readByte((ptr_addr + 1) & 0xFF);
+
+    // If low byte + Y carries, take an extra tick to correct the high byte
+    if (!dummy_read_optional || ((low_byte + Y) & 0x0100)) {
+      readByte(((low_byte + Y) & 0xFF) | high_byte << 8);  // Dummy read
     }
+    return (low_byte | high_byte << 8) + Y;
 
-    case (AddressingMode::indirect_y): {  // 3+ cycles
-      const uint8_t ptr_addr  = readByte(PC++);
-      const uint8_t low_byte  = readByte(ptr_addr);
-      const uint8_t high_byte = readByte((ptr_addr + 1) & 0xFF);
-
-      // If low byte + Y carries, take an extra tick to correct the high byte
-      if (!dummy_read_optional || ((low_byte + Y) & 0x0100)) {
-        readByte(((low_byte + Y) & 0xFF) | high_byte << 8);  // Dummy read
-      }
-      return (low_byte | high_byte << 8) + Y;
-    }
+  } else {
+    static_assert(Mode != Mode, "Addressing mode has no operand address");
+  }
+}
 
-    default:
-      logger::log<logger::ERROR>("Internal error, unknown addressing mode %d!\n", utils::asInt(mode));
-      reset(true);
-      return 0;
-  };
+template <class MapperT>
+template <hw::cpu::AddressingMode Mode, bool dummy_read_optional>
+uint8_t hw::cpu::CPU<MapperT>::readArg() {
+  if constexpr (Mode == AddressingMode::immediate) {  // 1 cycle
+    return fetch();
+  } else {
+    return readByte(getArgAddr<Mode, dummy_read_optional>());
+  }
 }
+
+
+#define INSTANTIATE(MapperT) template class hw::cpu::CPU<MapperT>;
+NESEMU_FOR_EACH_MAPPER(INSTANTIATE)
@@ -0,0 +1,261 @@
+#include <nesemu/hw/palette.h>
+
+#include <nesemu/logger.h>
+
+#include <cstring>  // memcpy
+#include <fstream>
+#include <utility>  // std::integer_sequence
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define NESEMU_X86_KERNELS 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#else
+#define NESEMU_X86_KERNELS 0
+#endif
+
+
+namespace {
+
+// RGB, ie. ARGB8888 with no alpha
+constexpr uint32_t DEFAULT_COLORS[64] = {
+    0x00757575, 0x00271B8F, 0x000000AB, 0x0047009F, 0x008F0077, 0x00AB0013, 0x00A70000, 0x007F0B00,
+    0x00432F00, 0x00004700, 0x00005100, 0x00003F17, 0x001B3F5F, 0x00000000, 0x00000000, 0x00000000,
+    0x00BCBCBC, 0x000073EF, 0x00233BEF, 0x008300F3, 0x00BF00BF, 0x00E7005B, 0x00DB2B00, 0x00CB4F0F,
+    0x008B7300, 0x00009700, 0x0000AB00, 0x0000933B, 0x0000838B, 0x00000000, 0x00000000, 0x00000000,
+    0x00FFFFFF, 0x003FBFFF, 0x005F97FF, 0x00A78BFD, 0x00F77BFF, 0x00FF77B7, 0x00FF7763, 0x00FF9B3B,
+    0x00F3BFF3, 0x0083D313, 0x004FDF4B, 0x0058F898, 0x0000EBDB, 0x003C3C3C, 0x00000000, 0x00000000,
+    0x00FFFFFF, 0x00ABE7FF, 0x00C7D7FF, 0x00D7CBFF, 0x00FFC7FF, 0x00FFC7DB, 0x00FFBFB3, 0x00FFDBAB,
+    0x00FFE7A3, 0x00E3FFA3, 0x00ABF3BF, 0x00B3FFCF, 0x009FFFF3, 0x00A0A2A0, 0x00000000, 0x00000000,
+};
+
+// TODO: Better tint/emphasis. Either more hw-accurate or just tune the numbers to look nice.
+constexpr float ATTENUATION = 0.746;
+
+template <uint8_t CHANNEL_POS>
+uint32_t attenuate(uint32_t color) {
+  constexpr uint32_t MASK = 0xFF << CHANNEL_POS;
+
+  uint8_t channel = (color & MASK) >> CHANNEL_POS;
+  channel *= ATTENUATION;
+  return (color & ~MASK) | (channel << CHANNEL_POS);
+}
+
+constexpr auto attenuate_red   = attenuate<16>;
+constexpr auto attenuate_green = attenuate<8>;
+constexpr auto attenuate_blue  = attenuate<0>;
+
+
+// =*=*=*=*= Conversion Kernels =*=*=*=*=
+
+// Each kernel converts and scales up one row at a time, horizontally. The row is then copied to scale vertically
+using hw::palette::HEIGHT;
+using hw::palette::WIDTH;
+using ConvertFn = void (*)(const uint32_t* colors, const uint16_t* pixels, uint32_t* argb);
+
+template <unsigned Scale>
+void repeatRow(uint32_t* row) {
+  for (unsigned i = 1; i < Scale; i++) {
+    std::memcpy(row + i * WIDTH * Scale, row, WIDTH * Scale * sizeof(uint32_t));
+  }
+}
+
+template <unsigned Scale>
+void convertScalar(const uint32_t* colors, const uint16_t* pixels, uint32_t* argb) {
+  for (unsigned y = 0; y < HEIGHT; y++) {
+    uint32_t* row = argb + y * WIDTH * Scale * Scale;
+    for (unsigned x = 0; x < WIDTH; x++) {
+      const uint32_t color = colors[pixels[y * WIDTH + x] & (hw::palette::NUM_ENTRIES - 1)];
+      for (unsigned i = 0; i < Scale; i++) {
+        row[x * Scale + i] = color;
+      }
+    }
+    repeatRow<Scale>(row);
+  }
+}
+
+#if NESEMU_X86_KERNELS
+// Which input pixel lands in each lane of the output vector, when a vector of pixels is scaled up into Scale vectors
+constexpr int sourceLane(unsigned scale, unsigned lanes, unsigned vector, unsigned lane) {
+  return (vector * lanes + lane) / scale;
+}
+
+template <unsigned Scale, unsigned Vector>
+constexpr int shuffleSSE2() {
+  return _MM_SHUFFLE(sourceLane(Scale, 4, Vector, 3),
+                     sourceLane(Scale, 4, Vector, 2),
+                     sourceLane(Scale, 4, Vector, 1),
+                     sourceLane(Scale, 4, Vector, 0));
+}
+
+template <unsigned Scale, unsigned... Vectors>
+TARGET("sse2") inline void storeSSE2(__m128i colors, uint32_t* argb, std::integer_sequence<unsigned, Vectors...>) {
+  __m128i* out = reinterpret_cast<__m128i*>(argb);
+  (_mm_storeu_si128(out + Vectors, _mm_shuffle_epi32(colors, (shuffleSSE2<Scale, Vectors>()))), ...);
+}
+
+template <unsigned Scale>
+TARGET("sse2") void convertSSE2(const uint32_t* colors, const uint16_t* pixels, uint32_t* argb) {
+  constexpr uint16_t MASK = hw::palette::NUM_ENTRIES - 1;
+  for (unsigned y = 0; y < HEIGHT; y++) {
+    const uint16_t* in  = pixels + y * WIDTH;
+    uint32_t*       row = argb + y * WIDTH * Scale * Scale;
+    for (unsigned x = 0; x < WIDTH; x += 4) {
+      const __m128i color = _mm_setr_epi32(colors[in[x] & MASK],
+                                           colors[in[x + 1] & MASK],
+                                           colors[in[x + 2] & MASK],
+                                           colors[in[x + 3] & MASK]);
+      storeSSE2<Scale>(color, row + x * Scale, std::make_integer_sequence<unsigned, Scale>());
+    }
+    repeatRow<Scale>(row);
+  }
+}
+
+template <unsigned Scale>
+TARGET("avx2") void convertAVX2(const uint32_t* colors, const uint16_t* pixels, uint32_t* argb) {
+  const __m256i mask = _mm256_set1_epi32(hw::palette::NUM_ENTRIES - 1);
+  __m256i       lanes[Scale];
+  for (unsigned i = 0; i < Scale; i++) {
+    lanes[i] = _mm256_setr_epi32(sourceLane(Scale, 8, i, 0),
+                                 sourceLane(Scale, 8, i, 1),
+                                 sourceLane(Scale, 8, i, 2),
+                                 sourceLane(Scale, 8, i, 3),
+                                 sourceLane(Scale, 8, i, 4),
+                                 sourceLane(Scale, 8, i, 5),
+                                 sourceLane(Scale, 8, i, 6),
+                                 sourceLane(Scale, 8, i, 7));
+  }
+
+  for (unsigned y = 0; y < HEIGHT; y++) {
+    const uint16_t* in  = pixels + y * WIDTH;
+    uint32_t*       row = argb + y * WIDTH * Scale * Scale;
+    for (unsigned x = 0; x < WIDTH; x += 8) {
+      const __m256i index = _mm256_and_si256(
+          _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + x))), mask);
+      const __m256i color = _mm256_i32gather_epi32(reinterpret_cast<const int*>(colors), index, 4);
+
+      __m256i* out = reinterpret_cast<__m256i*>(row + x * Scale);
+      for (unsigned i = 0; i < Scale; i++) {
+        _mm256_storeu_si256(out + i, _mm256_permutevar8x32_epi32(color, lanes[i]));
+      }
+    }
+    repeatRow<Scale>(row);
+  }
+}
+#endif
+
+// Indexed by [kernel][scale - 1]. Null if not compiled in
+constexpr ConvertFn KERNELS[][hw::palette::MAX_SCALE] = {
+    {convertScalar<1>, convertScalar<2>, convertScalar<3>, convertScalar<4>},
+#if NESEMU_X86_KERNELS
+    {convertSSE2<1>, convertSSE2<2>, convertSSE2<3>, convertSSE2<4>},
+    {convertAVX2<1>, convertAVX2<2>, convertAVX2<3>, convertAVX2<4>},
+#else
+    {nullptr, nullptr, nullptr, nullptr},
+    {nullptr, nullptr, nullptr, nullptr},
+#endif
+};
+
+}  // namespace
+
+
+hw::palette::Palette::Palette() : kernel_(bestKernel()) {
+  for (unsigned i = 0; i < 64; i++) {
+    colors_[i] = DEFAULT_COLORS[i];
+  }
+  emphasize();
+}
+
+int hw::palette::Palette::loadFromFile(const std::string& filename) {
+  std::ifstream file(filename, std::ios::in | std::ios::binary | std::ios::ate);
+  if (!file) {
+    logger::log<logger::ERROR>("Could not open palette file '%s'\n", filename.c_str());
+    return 1;
+  }
+
+  const std::streamoff size = file.tellg();
+  if (size != 64 * 3 && size != NUM_ENTRIES * 3) {
+    logger::log<logger::ERROR>("Palette file '%s' should have 64 or 512 RGB colors (192 or 1536 bytes)\n",
+                               filename.c_str());
+    return 1;
+  }
+
+  uint8_t rgb[NUM_ENTRIES * 3];
+  file.seekg(0, std::ios::beg);
+  file.read(reinterpret_cast<char*>(rgb), size);
+  if (!file) {
+    logger::log<logger::ERROR>("Could not read palette file '%s'\n", filename.c_str());
+    return 1;
+  }
+
+  for (unsigned i = 0; i < size / 3; i++) {
+    colors_[i] = rgb[i * 3] << 16 | rgb[i * 3 + 1] << 8 | rgb[i * 3 + 2];
+  }
+  if (size == 64 * 3) {
+    emphasize();
+  }
+  return 0;
+}
+
+int hw::palette::Palette::convert(const uint16_t* pixels, uint32_t* argb, unsigned scale) const {
+  if (scale < 1 || scale > MAX_SCALE) {
+    logger::log<logger::ERROR>("Can't scale frames by %u, only 1 to %u\n", scale, MAX_SCALE);
+    return 1;
+  }
+  KERNELS[static_cast<unsigned>(kernel_)][scale - 1](colors_, pixels, argb);
+  return 0;
+}
+
+int hw::palette::Palette::setKernel(Kernel kernel) {
+  if (!supports(kernel)) {
+    return 1;
+  }
+  kernel_ = kernel;
+  return 0;
+}
+
+bool hw::palette::Palette::supports(Kernel kernel) {
+  switch (kernel) {
+    case Kernel::SCALAR:
+      return true;
+#if NESEMU_X86_KERNELS
+    case Kernel::SSE2:
+      return __builtin_cpu_supports("sse2");
+    case Kernel::AVX2:
+      return __builtin_cpu_supports("avx2");
+#else
+    case Kernel::SSE2:
+    case Kernel::AVX2:
+      return false;
+#endif
+  }
+  return false;
+}
+
+hw::palette::Kernel hw::palette::Palette::bestKernel() {
+  for (const Kernel kernel : {Kernel::AVX2, Kernel::SSE2}) {
+    if (supports(kernel)) {
+      return kernel;
+    }
+  }
+  return Kernel::SCALAR;
+}
+
+void hw::palette::Palette::emphasize() {
+  for (unsigned i = 64; i < NUM_ENTRIES; i++) {
+    uint32_t rgb = colors_[i & 0x3F];
+    if (i & 0x40) {  // Red
+      rgb = attenuate_green(rgb);
+      rgb = attenuate_blue(rgb);
+    }
+    if (i & 0x80) {  // Green
+      rgb = attenuate_red(rgb);
+      rgb = attenuate_blue(rgb);
+    }
+    if (i & 0x100) {  // Blue
+      rgb = attenuate_red(rgb);
+      rgb = attenuate_green(rgb);
+    }
+    colors_[i] = rgb;
+  }
+}
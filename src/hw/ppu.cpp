@@ -1,24 +1,32 @@
 #include <nesemu/hw/ppu.h>
 
 #include <nesemu/debug.h>
-#include <nesemu/hw/mapper/mapper_base.h>
+#include <nesemu/hw/io.h>
+#include <nesemu/hw/mapper/mapper_types.h>
 #include <nesemu/logger.h>
-#include <nesemu/temp_mapping.h>
-#include <nesemu/ui/screen.h>
 #include <nesemu/utils/enum.h>
 
-#include <cstring>  // For memcpy
+#include <algorithm>  // std::min
+#include <cstring>    // For memcpy, memset
 
 
 // =*=*=*=*= PPU Setup =*=*=*=*=
 
-void hw::ppu::PPU::loadCart(mapper::Mapper* mapper, uint8_t* chr_mem, bool is_ram) {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::loadCart(MapperT* mapper, bool is_ram) {
   mapper_         = mapper;
-  chr_mem_        = chr_mem;
   chr_mem_is_ram_ = is_ram;
+  mapper_->connectCIRAM(ram_);
+
+  chr_rows_.resize(mapper_->chrSize() / 2);
+  for (uint32_t offset = 0; offset < mapper_->chrSize(); offset += 16) {
+    for (uint32_t row = 0; row < 8; row++) {
+      decodeChrRow(offset + row);
+    }
+  }
 }
 
-void hw::ppu::PPU::setScreen(ui::Screen* screen) {
+void hw::ppu::PPU::setScreen(io::VideoSink* screen) {
   screen_ = screen;
 }
 
@@ -29,7 +37,42 @@ bool hw::ppu::PPU::hasNMI() {
   return (vblank_suppression_counter_ == 0) && status_reg_.vblank && ctrl_reg_1_.vblank_enable;
 }
 
-void hw::ppu::PPU::clock() {
+uint32_t hw::ppu::PPU::statusStableDots() const {
+  // Reading PPUSTATUS clears VBlank, and reading it just before VBlank starts suppresses it
+  if (status_reg_.vblank || vblank_suppression_counter_ != 0) {
+    return 0;
+  }
+
+  // VBlank is set on line 241, and all flags are cleared on the pre-render line
+  static constexpr uint32_t MARGIN = 4;
+  uint32_t                  stable = std::min(dotsUntil(241, 1), dotsUntil(261, 1));
+
+  // Sprite zero hit and sprite overflow can be set during dots 0-256 of any visible line while rendering
+  if (ctrl_reg_2_.render_enable && !(did_hit_sprite_zero_ && status_reg_.overflow)) {
+    if (scanline_ < 240 && cycle_ <= 256) {
+      return 0;
+    }
+    stable = std::min(stable, dotsUntil(scanline_ < 240 ? scanline_ + 1 : 0, 0));
+  }
+
+  return stable > MARGIN ? stable - MARGIN : 0;
+}
+
+uint32_t hw::ppu::PPU::dotsUntilEvent() const {
+  // The NMI output changes when the VBlank flag is suppressed, set or cleared, and the frame ends on the post-render
+  // line. Changes made by the CPU, through the registers, are its own business
+  if (vblank_suppression_counter_ != 0) {
+    return 1;
+  }
+  return std::min({dotsUntil(240, 0), dotsUntil(241, 1), dotsUntil(261, 1)}) + 1;
+}
+
+hw::ppu::Registers hw::ppu::PPU::registers() const {
+  return {v_.raw, t_.raw, fine_x_scroll_, status_reg_, scanline_, cycle_};
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::clock() {
   uint16_t scanline_length = 341;
 
 
@@ -46,7 +89,10 @@ void hw::ppu::PPU::clock() {
   // =*=*=*=*=  Post-render scanline (Idle) =*=*=*=*=
   else if (scanline_ < 241) {
     if (cycle_ == 0) {
-      screen_->update(pixels_);
+      frame_count_++;
+      if (screen_ && draw_frame_) {
+        screen_->update(pixels_);
+      }
     }
   }
 
@@ -66,6 +112,10 @@ void hw::ppu::PPU::clock() {
       status_reg_.overflow = false;
       status_reg_.hit      = false;
       status_reg_.vblank   = false;
+
+      // Decide whether to draw the coming frame. frame_count_ is its number
+      draw_frame_        = render_next_frame_ || (frame_skip_ != 0 && frame_count_ % frame_skip_ == 0);
+      render_next_frame_ = false;
     }
 
     // On odd frames, shorted pre_render scanline by 1
@@ -77,7 +127,7 @@ void hw::ppu::PPU::clock() {
       v_.coarse_y_scroll  = t_.coarse_y_scroll;
       v_.nametable_select = (v_.nametable_select & 0x01) | (t_.nametable_select & 0x02);
       v_.fine_y_scroll    = t_.fine_y_scroll;
-      mapper_->decodePPUAddress(v_.raw);
+      snoopAddress(v_.raw);
     }
 
     fetchTilesAndSprites(false);
@@ -103,7 +153,104 @@ void hw::ppu::PPU::clock() {
   }
 }
 
-uint8_t hw::ppu::PPU::readRegister(uint16_t cpu_address) {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::run(uint32_t dots) {
+  // Nothing outside the PPU can change during a run, as the bus catches the PPU up before anything which could affect
+  // it. So visible lines which are run from start to end can be rendered in one go
+  const bool by_line = (renderer_ == Renderer::SCANLINES) && !mapper()->snoopsPPU();
+  while (dots > 0) {
+    if (by_line && dots >= 341 && cycle_ == 0 && scanline_ < 240 && vblank_suppression_counter_ == 0) {
+      renderScanline();
+      dots -= 341;
+    } else {
+      clock();
+      dots--;
+    }
+  }
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::renderScanline() {
+  SpriteEvaluationFSM& fsm       = sprite_eval_fsm_;
+  const bool           rendering = ctrl_reg_2_.render_enable;
+
+  // The palette can't change mid-line, so only look up each color once
+  uint16_t colors[0x20];
+  if (draw_frame_) {
+    for (uint8_t i = 0; i < 0x20; i++) {
+      colors[i] = pixelColor(i);
+    }
+  }
+
+  // Dot 0: Start the sprite evaluation, and switch to the sprites fetched during the last line
+  fsm.state_           = SpriteEvaluationFSM::State::CHECK_Y_IN_RANGE;
+  fsm.poam_index_      = 0;
+  fsm.soam_index_      = 0;
+  sr_has_sprite_zero_  = oam_has_sprite_zero_;
+  oam_has_sprite_zero_ = false;
+
+  // Dots 0-255: Draw the line, fetching a background tile after every 8 pixels. Dot 256 only fetches. On skipped
+  // frames, the pixels only matter if they could hit sprite zero
+  const bool skip_pixels = !draw_frame_ && (!sr_has_sprite_zero_ || did_hit_sprite_zero_);
+  uint16_t*  row         = pixels_ + scanline_ * 256;
+  for (uint16_t x = 0; x < 256; x += 8) {
+    if (rendering && x != 0) {
+      cycle_ = x;
+      fetchNextBGTile();
+    }
+    if (skip_pixels) {
+      skipTile();
+    } else if (!draw_frame_) {
+      for (uint16_t i = x; i < x + 8; i++) {
+        nextPixel(i);
+      }
+    } else {
+      for (uint16_t i = x; i < x + 8; i++) {
+        row[i] = colors[nextPixel(i)];
+      }
+    }
+  }
+  cycle_ = 256;
+  if (rendering) {
+    fetchNextBGTile();
+  }
+
+  // Dots 1-64: Clear the secondary OAM
+  std::memset(secondary_oam_.byte, 0xFF, 32);
+  fsm.latch_      = 0xFF;
+  fsm.initialize_ = false;
+
+  // Dots 65-256: Evaluate the sprites for the next line. Odd dots read primary OAM, even dots write secondary OAM
+  if (rendering) {
+    for (cycle_ = 65; cycle_ < 257; cycle_ += 2) {
+      fsm.latch_ = primary_oam_.byte[fsm.poam_index_];
+      evaluateSprite();
+    }
+  }
+
+  // Dots 257-320: Fetch the sprites for the next line
+  cycle_ = 257;
+  startSpriteFetch();
+  if (rendering) {
+    for (unsigned i = 0; i < 8; i++) {
+      fetchNextSprite();
+    }
+  }
+
+  // Dots 321-336: Fetch the first two background tiles for the next line. Dots 337-340 only make dummy fetches
+  if (rendering) {
+    cycle_ = 328;
+    fetchFirstBGTile();
+    cycle_ = 336;
+    fetchNextBGTile();
+  }
+
+  cycle_ = 0;
+  scanline_++;
+}
+
+template <class MapperT>
+uint8_t hw::ppu::internal::PPU<MapperT>::readRegister(uint16_t cpu_address) {
   switch (cpu_address) {
     case (utils::asInt(MemoryMappedIO::PPUCTRL)):  // PPU Control Register 1 (Write-only)
       logger::log<logger::DEBUG_PPU>("Read $%02X from PPUCTRL (Open bus)\n", io_latch_);
@@ -143,14 +290,13 @@ uint8_t hw::ppu::PPU::readRegister(uint16_t cpu_address) {
       break;
 
     case (utils::asInt(MemoryMappedIO::PPUDATA)): {  // PPU Memory Data
-      static uint8_t read_buffer;
       if (v_.raw < 0x3F00) {
-        io_latch_   = read_buffer;
-        read_buffer = readByte(v_.raw);
+        io_latch_    = read_buffer_;
+        read_buffer_ = readByte(v_.raw);
       } else {
         // TODO: Double check this buffer
-        read_buffer = readByte(0x2000 | (v_.raw & 0x0FFF));
-        io_latch_   = readByte(v_.raw);
+        read_buffer_ = readByte(0x2000 | (v_.raw & 0x0FFF));
+        io_latch_    = readByte(v_.raw);
       }
 
       if ((scanline_ == 261 || scanline_ < 240) && ctrl_reg_2_.render_enable) {
@@ -158,7 +304,7 @@ uint8_t hw::ppu::PPU::readRegister(uint16_t cpu_address) {
         incrementFineY();
       } else {
         v_.raw += (ctrl_reg_1_.vertical_write ? 32 : 1);
-        mapper_->decodePPUAddress(v_.raw);
+        snoopAddress(v_.raw);
       }
 
       logger::log<logger::DEBUG_PPU>("Read $%02X from PPUDATA\n", io_latch_);
@@ -172,7 +318,8 @@ uint8_t hw::ppu::PPU::readRegister(uint16_t cpu_address) {
   return io_latch_;
 }
 
-void hw::ppu::PPU::writeRegister(uint16_t cpu_address, uint8_t data) {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::writeRegister(uint16_t cpu_address, uint8_t data) {
   io_latch_ = data;
 
   switch (cpu_address) {
@@ -218,7 +365,7 @@ void hw::ppu::PPU::writeRegister(uint16_t cpu_address, uint8_t data) {
       if (write_toggle_) {                         // Write lower byte on second write
         t_.lower = data;
         v_.raw   = t_.raw;
-        mapper_->decodePPUAddress(v_.raw);
+        snoopAddress(v_.raw);
       } else {  // Write upper byte on first write
         t_.upper = data & 0x3F;
       }
@@ -233,7 +380,7 @@ void hw::ppu::PPU::writeRegister(uint16_t cpu_address, uint8_t data) {
         incrementFineY();
       } else {
         v_.raw += (ctrl_reg_1_.vertical_write ? 32 : 1);
-        mapper_->decodePPUAddress(v_.raw);
+        snoopAddress(v_.raw);
       }
       logger::log<logger::DEBUG_PPU>("Set PPUDATA = $%02X\n", data);
       break;
@@ -244,110 +391,263 @@ void hw::ppu::PPU::writeRegister(uint16_t cpu_address, uint8_t data) {
   }
 }
 
-void hw::ppu::PPU::spriteDMAWrite(uint8_t* data) {
+void hw::ppu::PPU::spriteDMAWrite(const uint8_t* data) {
   memcpy(primary_oam_.byte + oam_addr_, data, 256 - oam_addr_);
   memcpy(primary_oam_.byte, data + 256 - oam_addr_, oam_addr_);
 }
 
 
+// =*=*=*=*= PPU Save States =*=*=*=*=
+
+void hw::ppu::PPU::saveState(state::Writer* out) const {
+  // Sprite evaluation
+  out->put(static_cast<uint8_t>(sprite_eval_fsm_.state_));
+  out->put(sprite_eval_fsm_.state_counter_);
+  out->put(sprite_eval_fsm_.poam_index_);
+  out->put(sprite_eval_fsm_.soam_index_);
+  out->put(sprite_eval_fsm_.latch_);
+  out->put(sprite_eval_fsm_.initialize_);
+
+  // Background registers
+  out->put(t_.raw.data);
+  out->put(v_.raw.data);
+  out->put(static_cast<uint8_t>(fine_x_scroll_));
+  out->put(write_toggle_);
+  out->put(pattern_sr_);
+  out->put(palette_sr_a_);
+  out->put(palette_sr_b_);
+  out->put(palette_latch_a_);
+  out->put(palette_latch_b_);
+
+  // Sprite registers
+  out->putBytes(primary_oam_.byte, sizeof(primary_oam_));
+  out->putBytes(secondary_oam_.byte, sizeof(secondary_oam_));
+  out->put(num_sprites_fetched_);
+  out->put(oam_has_sprite_zero_);
+  out->put(sr_has_sprite_zero_);
+  out->put(did_hit_sprite_zero_);
+  out->putBytes(sprite_line_, sizeof(sprite_line_));
+
+  // Memory-mapped IO registers
+  out->put(io_latch_);
+  out->put(static_cast<uint8_t>(ctrl_reg_1_));
+  out->put(static_cast<uint8_t>(ctrl_reg_2_));
+  out->put(static_cast<uint8_t>(status_reg_));
+  out->put(oam_addr_);
+  out->put(read_buffer_);
+  out->put(vblank_suppression_counter_);
+
+  // CIRAM (4 nametables, at most), palettes and CHR RAM
+  out->putBytes(ram_, 0x1000);
+  out->putBytes(ram_ + 0x1F00, 0x20);
+  if (chr_mem_is_ram_) {
+    out->putBytes(mapper_->chrMemory(), mapper_->chrSize());
+  }
+
+  // Rendering
+  out->put(scanline_);
+  out->put(cycle_);
+  out->put(frame_is_odd_);
+  out->put(frame_count_);
+}
+
+void hw::ppu::PPU::loadState(state::Reader* in) {
+  // Sprite evaluation
+  sprite_eval_fsm_.state_ = static_cast<SpriteEvaluationFSM::State>(in->get<uint8_t>());
+  in->get(sprite_eval_fsm_.state_counter_);
+  in->get(sprite_eval_fsm_.poam_index_);
+  in->get(sprite_eval_fsm_.soam_index_);
+  in->get(sprite_eval_fsm_.latch_);
+  in->get(sprite_eval_fsm_.initialize_);
+
+  // Background registers
+  t_.raw.data    = in->get<uint16_t>();
+  v_.raw.data    = in->get<uint16_t>();
+  fine_x_scroll_ = in->get<uint8_t>() & 0x07;
+  in->get(write_toggle_);
+  in->get(pattern_sr_);
+  in->get(palette_sr_a_);
+  in->get(palette_sr_b_);
+  in->get(palette_latch_a_);
+  in->get(palette_latch_b_);
+
+  // Sprite registers
+  in->getBytes(primary_oam_.byte, sizeof(primary_oam_));
+  in->getBytes(secondary_oam_.byte, sizeof(secondary_oam_));
+  in->get(num_sprites_fetched_);
+  in->get(oam_has_sprite_zero_);
+  in->get(sr_has_sprite_zero_);
+  in->get(did_hit_sprite_zero_);
+  in->getBytes(sprite_line_, sizeof(sprite_line_));
+
+  // Memory-mapped IO registers
+  in->get(io_latch_);
+  ctrl_reg_1_ = in->get<uint8_t>();
+  ctrl_reg_2_ = in->get<uint8_t>();
+  status_reg_ = in->get<uint8_t>();
+  in->get(oam_addr_);
+  in->get(read_buffer_);
+  in->get(vblank_suppression_counter_);
+
+  // CIRAM (4 nametables, at most), palettes and CHR RAM. Only the tiles which changed are decoded again, as decoding
+  // all of them takes far longer than the rest of the load
+  in->getBytes(ram_, 0x1000);
+  in->getBytes(ram_ + 0x1F00, 0x20);
+  if (chr_mem_is_ram_) {
+    const uint32_t size = mapper_->chrSize();
+    const uint8_t* chr     = in->view(size);
+    uint8_t*       chr_mem = mapper_->chrMemory();
+    if (chr && memcmp(chr_mem, chr, size) != 0) {
+      for (uint32_t offset = 0; offset < size; offset += 16) {
+        if (memcmp(chr_mem + offset, chr + offset, 16) != 0) {
+          memcpy(chr_mem + offset, chr + offset, 16);
+          for (uint32_t row = 0; row < 8; row++) {
+            decodeChrRow(offset + row);
+          }
+        }
+      }
+    }
+  }
+
+  // Rendering
+  in->get(scanline_);
+  in->get(cycle_);
+  in->get(frame_is_odd_);
+  in->get(frame_count_);
+}
+
+
 // =*=*=*=*= PPU Internal Operations =*=*=*=*=
 
-uint8_t hw::ppu::PPU::readByte(uint16_t address) const {
+uint8_t hw::ppu::PPU::peekByte(uint16_t address) const {
+  address &= 0x3FFF;
+
+  if (address < 0x2000) {  // Cartridge VRAM/VROM
+    return *mapper_->chr(address);
+  } else if (address < 0x3F00) {  // Nametables
+    return *mapper_->ciram(address);
+  } else {  // Palettes
+    return ram_[paletteAddress(address)];
+  }
+}
+
+void hw::ppu::PPU::decodeChrRow(uint32_t offset) {
+  const uint8_t* chr       = mapper_->chrMemory() + (offset & ~0x08);
+  const uint8_t  pattern_a = chr[0];
+  const uint8_t  pattern_b = chr[8];
+
+  ChrRow& row = chr_rows_[chrRowIndex(offset)];
+  row         = {0, 0};
+  for (unsigned i = 0; i < 8; i++) {
+    const uint8_t pixel = ((pattern_a >> (7 - i)) & 0x01) | (((pattern_b >> (7 - i)) << 1) & 0x02);
+    row.pixels |= pixel << (14 - i * 2);
+    row.flipped |= pixel << (i * 2);
+  }
+}
+
+const hw::ppu::PPU::ChrRow& hw::ppu::PPU::chrRow(uint16_t address) const {
+  return chr_rows_[chrRowIndex(mapper_->chrOffset(address))];
+}
+
+uint32_t hw::ppu::PPU::dotsUntil(uint16_t scanline, uint16_t cycle) const {
+  // The pre-render line is a dot short on odd frames, so when wrapping around, assume it is
+  static constexpr uint32_t FRAME_LENGTH = 262 * 341;
+  const uint32_t            now          = scanline_ * 341 + cycle_;
+  const uint32_t            target       = scanline * 341 + cycle;
+  return target >= now ? target - now : target + FRAME_LENGTH - now - 1;
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::snoopAddress(uint16_t address) const {
+  if (mapper()->snoopsPPU()) {
+    mapper()->snoopPPUAddress(address);
+  }
+}
+
+template <class MapperT>
+uint8_t hw::ppu::internal::PPU<MapperT>::readByte(uint16_t address) const {
   uint8_t data;
   address &= 0x3FFF;
 
   // Cartridge VRAM/VROM
   if (address < 0x2000) {
-    data = chr_mem_[mapper_->decodePPUAddress(address)];
+    snoopAddress(address);
+    data = *mapper()->chr(address);
+  }
+
+  // Nametables
+  else if (address < 0x3F00) {
+    data = *mapper()->ciram(address);
   }
 
-  // Nametables & palettes
+  // Palettes
   else {
-    data = ram_[mapper_->decodeCIRAMAddress(address)];
+    data = ram_[paletteAddress(address)];
   }
 
   return data;
 }
 
 
-void hw::ppu::PPU::writeByte(uint16_t address, uint8_t data) {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::writeByte(uint16_t address, uint8_t data) {
   address &= 0x3FFF;
 
   // Cartridge VRAM/VROM
   if (address < 0x2000) {
-    if (chr_mem_is_ram_)  // Uses VRAM, not VROM
-      chr_mem_[mapper_->decodePPUAddress(address)] = data;
+    snoopAddress(address);
+    if (chr_mem_is_ram_) {  // Uses VRAM, not VROM
+      *mapper()->chr(address) = data;
+      decodeChrRow(mapper()->chrOffset(address));
+    }
   }
 
-  // Nametables & palettes
+  // Nametables
+  else if (address < 0x3F00) {
+    *mapper()->ciram(address) = data;
+  }
+
+  // Palettes
   else {
-    ram_[mapper_->decodeCIRAMAddress(address)] = data;
+    ram_[paletteAddress(address)] = data;
+  }
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::renderPixel() {
+  const uint8_t palette_addr = nextPixel(cycle_);
+  if (draw_frame_) {
+    pixels_[(scanline_ * 256) + cycle_] = pixelColor(palette_addr);
   }
 }
 
-void hw::ppu::PPU::renderPixel() {
+template <class MapperT>
+uint8_t hw::ppu::internal::PPU<MapperT>::nextPixel(uint16_t x) {
 
   // Determine background pixel and palette
-  uint8_t bg_pixel = ((pattern_sr_a_ >> (15 - fine_x_scroll_)) & 0x01)
-                     | (((pattern_sr_b_ >> (15 - fine_x_scroll_)) << 1) & 0x02);
+  uint8_t bg_pixel = (pattern_sr_ >> (30 - fine_x_scroll_ * 2)) & 0x03;
   const uint8_t bg_palette = ((palette_sr_a_ >> (7 - fine_x_scroll_)) & 0x01)
                              | (((palette_sr_b_ >> (7 - fine_x_scroll_)) << 1) & 0x02);
 
   // If background renderind is disabled or left column is masked, set pixel to 0
-  if (!ctrl_reg_2_.bg_enable || (cycle_ < 8 && !ctrl_reg_2_.bg_mask)) {
+  if (!ctrl_reg_2_.bg_enable || (x < 8 && !ctrl_reg_2_.bg_mask)) {
     bg_pixel = 0;
   }
 
-  uint8_t sprite_pixel    = 0;
-  uint8_t sprite_palette  = 0;
-  uint8_t sprite_priority = 0;
-  for (unsigned i = 0; i < num_sprites_fetched_; i++) {
-
-    // Decrement x position until cur dot intersects sprite
-    if (sprite_x_position_[i] != 0) {
-      sprite_x_position_[i]--;
-    }
-
-    // Otherwise, determine the pixel of the sprite
-    else {
-      const bool pixel_found = sprite_pixel != 0;
-
-      if (sprite_palette_latch_[i].flip_horiz) {
-
-        // Skip if pixel already found, or if sprite rendering is disabled or left column is masked
-        if (!pixel_found && ctrl_reg_2_.sprite_enable && (cycle_ > 7 || ctrl_reg_2_.sprite_mask)) {
-          sprite_pixel = (sprite_pattern_sr_a_[i] & 0x01) | ((sprite_pattern_sr_b_[i] << 1) & 0x02);
-        }
-        sprite_pattern_sr_a_[i] >>= 1;
-        sprite_pattern_sr_b_[i] >>= 1;
-      } else {
-
-        // Skip if pixel already found, or if sprite rendering is disabled or left column is masked
-        if (!pixel_found && ctrl_reg_2_.sprite_enable && (cycle_ > 7 || ctrl_reg_2_.sprite_mask)) {
-          sprite_pixel = ((sprite_pattern_sr_a_[i] >> 7) & 0x01) | ((sprite_pattern_sr_b_[i] >> 6) & 0x02);
-        }
-        sprite_pattern_sr_a_[i] <<= 1;
-        sprite_pattern_sr_b_[i] <<= 1;
-      }
-
-      // Sprite zero hit
-      // if (i == 0 && sr_has_sprite_zero_ && !did_hit_sprite_zero_) {
-      //   printf("s=%d\tc=%d\tbg_pixel=%d, sprite_pixel=%d\n", scanline_, cycle_, bg_pixel, sprite_pixel);
-      // }
-      if (i == 0 && sr_has_sprite_zero_          // Sprite is #0
-          && cycle_ != 255                       // Not right-most pixel
-          && bg_pixel != 0 && sprite_pixel != 0  // Both BG and sprite are opaque
-          && !did_hit_sprite_zero_) {            // Hasn't already hit this frame
-        // printf("Hit, S=%d\n", scanline_);
-        did_hit_sprite_zero_ = true;
-        status_reg_.hit      = true;
-      }
+  // Look up the sprite pixel. If sprite rendering is disabled or left column is masked, treat it as transparent
+  const SpritePixel sprite       = sprite_line_[x];
+  uint8_t           sprite_pixel = 0;
+  if (ctrl_reg_2_.sprite_enable && (x > 7 || ctrl_reg_2_.sprite_mask)) {
+    sprite_pixel = sprite.pixel;
+  }
 
-      if (!pixel_found) {
-        sprite_palette  = sprite_palette_latch_[i].palette;
-        sprite_priority = sprite_palette_latch_[i].priority;
-      }
-    }
+  // Sprite zero hit
+  if (sprite.sprite_zero && sr_has_sprite_zero_  // Sprite is #0
+      && x != 255                                // Not right-most pixel
+      && bg_pixel != 0 && sprite_pixel != 0      // Both BG and sprite are opaque
+      && !did_hit_sprite_zero_) {                // Hasn't already hit this frame
+    did_hit_sprite_zero_ = true;
+    status_reg_.hit      = true;
   }
 
   uint8_t palette_addr;
@@ -364,45 +664,39 @@ void hw::ppu::PPU::renderPixel() {
     } else {
       palette_addr = 0;
     }
-  } else if (sprite_pixel == 0 || (bg_pixel != 0 && sprite_priority == 1)) {
+  } else if (sprite_pixel == 0 || (bg_pixel != 0 && sprite.priority)) {
     palette_addr = bg_pixel | (bg_palette << 2);
   } else {
-    palette_addr = sprite_pixel | (sprite_palette << 2) | 0x10;
+    palette_addr = sprite_pixel | (sprite.palette << 2) | 0x10;
   }
 
-
-  // Write the pixel to the screen buffer
-  const uint8_t color = readByte(0x3F00 | palette_addr) & (ctrl_reg_2_.greyscale ? 0x30 : 0xFF);
-  uint32_t      rgb   = decodeColor(color);
-
-  // TODO: Better tint/emphasis. Either more hw-accurate or just tune the numbers to look nice.
-  constexpr float ATTENUATION = 0.746;
-  if (ctrl_reg_2_.tint_red) {
-    rgb = attenuate_green(rgb, ATTENUATION);
-    rgb = attenuate_blue(rgb, ATTENUATION);
-  }
-  if (ctrl_reg_2_.tint_green) {
-    rgb = attenuate_red(rgb, ATTENUATION);
-    rgb = attenuate_blue(rgb, ATTENUATION);
-  }
-  if (ctrl_reg_2_.tint_blue) {
-    rgb = attenuate_red(rgb, ATTENUATION);
-    rgb = attenuate_green(rgb, ATTENUATION);
-  }
-
-  pixels_[(scanline_ * 256) + cycle_] = rgb;
   // Shift SRs left
-  pattern_sr_a_ <<= 1;
-  pattern_sr_b_ <<= 1;
+  pattern_sr_ <<= 2;
   palette_sr_a_ <<= 1;
   palette_sr_b_ <<= 1;
 
   // Load palette SRs from latch
   palette_sr_a_ |= static_cast<uint8_t>(palette_latch_a_);
   palette_sr_b_ |= static_cast<uint8_t>(palette_latch_b_);
+
+  return palette_addr;
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::skipTile() {
+  // Same as 8 calls to nextPixel(), less the pixels
+  pattern_sr_ <<= 16;
+  palette_sr_a_ = palette_latch_a_ ? 0xFF : 0x00;
+  palette_sr_b_ = palette_latch_b_ ? 0xFF : 0x00;
+}
+
+uint16_t hw::ppu::PPU::pixelColor(uint8_t palette_addr) const {
+  const uint8_t color = ram_[paletteAddress(palette_addr)] & (ctrl_reg_2_.greyscale ? 0x30 : 0x3F);
+  return color | (ctrl_reg_2_.tint_red.to() | ctrl_reg_2_.tint_green.to() | ctrl_reg_2_.tint_blue.to()) << 1;
 }
 
-void hw::ppu::PPU::fetchTilesAndSprites(bool /*fetch_sprites*/) {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::fetchTilesAndSprites(bool /*fetch_sprites*/) {
   // TODO: Should fetch_sprites be unused?
 
   // Sprite evaluation fsm
@@ -450,98 +744,10 @@ void hw::ppu::PPU::fetchTilesAndSprites(bool /*fetch_sprites*/) {
         fetchNextBGTile();
       }
 
-      const uint8_t sprite_height = ctrl_reg_1_.large_sprites ? 16 : 8;
-
       if ((cycle_ % 2) == 1) {
         fsm.latch_ = primary_oam_.byte[fsm.poam_index_];
       } else {
-
-        switch (fsm.state_) {
-          using State = SpriteEvaluationFSM::State;
-
-          // If Y val in range, copy over rest of sprite data into secondary OAM
-          case State::CHECK_Y_IN_RANGE:
-            // TODO: Why does Y-3 fix ppu_sprite_hit/rom_singles/07-screen_bottom.nes?
-            secondary_oam_.byte[fsm.soam_index_] = fsm.latch_;
-            if (fsm.latch_ <= scanline_ && uint8_t(fsm.latch_ + sprite_height) > scanline_) {
-              if (fsm.poam_index_ == 0) {
-                oam_has_sprite_zero_ = true;
-              }
-              // if (fsm.latch_ == 238 || fsm.latch_ == 239) {
-              //   printf("Y=%d, S=%d\n", fsm.latch_, scanline_);
-              // }
-              fsm.state_         = State::COPY_SPRITE;
-              fsm.state_counter_ = 3;
-              fsm.soam_index_++;
-              fsm.poam_index_++;
-            } else {
-              fsm.poam_index_ += 4;
-              if (fsm.poam_index_ == 0) {
-                fsm.state_ = State::DONE;
-              }
-            }
-            break;
-
-          // Copy sprite data into seconary OAM
-          case State::COPY_SPRITE:
-            secondary_oam_.byte[fsm.soam_index_++] = fsm.latch_;
-            fsm.poam_index_++;
-
-            fsm.state_counter_--;
-            if (fsm.state_counter_ == 0) {
-
-              // Primary OAM index overflowed, therefore all 64 sprites have been evaluated
-              if (fsm.poam_index_ == 0) {
-                fsm.state_ = State::DONE;
-              }
-
-              // Secondary OAM not yet full, so continue scanning through Primary OAM
-              else if (fsm.soam_index_ < 32) {
-                fsm.state_ = State::CHECK_Y_IN_RANGE;
-              }
-
-              // Secondary OAM is full, check for sprite overflow
-              else {
-                fsm.state_ = State::OVERFLOW;
-              }
-            }
-            break;
-
-          // Check if Y val in range
-          case State::OVERFLOW:
-            if (fsm.latch_ <= scanline_ && uint8_t(fsm.latch_ + sprite_height) > scanline_) {
-              status_reg_.overflow = true;
-
-              fsm.poam_index_++;
-              fsm.state_         = State::DUMMY_READ;
-              fsm.state_counter_ = 3;
-            } else {
-              fsm.poam_index_ += 4;
-              if ((fsm.poam_index_ / 4) == 0) {
-                fsm.state_ = State::DONE;
-              } else {
-                fsm.poam_index_ = (fsm.poam_index_ & 0xFC) | ((fsm.poam_index_ + 1) & 0x03);
-              }
-            }
-
-            break;
-
-          // Dummy read
-          case State::DUMMY_READ:
-            fsm.poam_index_++;
-            fsm.state_counter_--;
-            if (fsm.state_counter_ == 0) {
-              fsm.state_ = State::OVERFLOW;
-            }
-            break;
-
-          // Do nothing; Just read next sprite, and discard result
-          case State::DONE:
-            fsm.poam_index_ += 4;
-            break;
-
-            // No default
-        }
+        evaluateSprite();
       }
     }
   }
@@ -549,19 +755,7 @@ void hw::ppu::PPU::fetchTilesAndSprites(bool /*fetch_sprites*/) {
   // Cycles 257-320: Fetch sprites for the next scanline
   else if (cycle_ < 321) {
     if (cycle_ == 257) {
-      if (ctrl_reg_2_.render_enable) {
-        v_.coarse_x_scroll  = t_.coarse_x_scroll;
-        v_.nametable_select = (t_.nametable_select & 0x01) | (v_.nametable_select & 0x02);
-      }
-      num_sprites_fetched_ = 0;
-
-      // Clear old sprites
-      for (unsigned i = 0; i < 8; i++) {
-        sprite_pattern_sr_a_[i]  = 0;
-        sprite_pattern_sr_b_[i]  = 0;
-        sprite_palette_latch_[i] = {};
-        sprite_x_position_[i]    = 0;
-      }
+      startSpriteFetch();
     }
 
     if (ctrl_reg_2_.render_enable && (cycle_ % 8) == 0) {
@@ -575,11 +769,7 @@ void hw::ppu::PPU::fetchTilesAndSprites(bool /*fetch_sprites*/) {
     // Load tile 0
     if (ctrl_reg_2_.render_enable) {
       if (cycle_ == 328) {
-        fetchNextBGTile();
-        pattern_sr_a_ <<= 8;
-        pattern_sr_b_ <<= 8;
-        palette_sr_a_ = palette_latch_a_ ? -1 : 0;
-        palette_sr_b_ = palette_latch_b_ ? -1 : 0;
+        fetchFirstBGTile();
       }
 
       // Load tile 1
@@ -597,7 +787,123 @@ void hw::ppu::PPU::fetchTilesAndSprites(bool /*fetch_sprites*/) {
   }
 }
 
-void hw::ppu::PPU::fetchNextBGTile() {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::evaluateSprite() {
+  SpriteEvaluationFSM& fsm           = sprite_eval_fsm_;
+  const uint8_t        sprite_height = ctrl_reg_1_.large_sprites ? 16 : 8;
+
+  switch (fsm.state_) {
+    using State = SpriteEvaluationFSM::State;
+
+    // If Y val in range, copy over rest of sprite data into secondary OAM
+    case State::CHECK_Y_IN_RANGE:
+      // TODO: Why does Y-3 fix ppu_sprite_hit/rom_singles/07-screen_bottom.nes?
+      secondary_oam_.byte[fsm.soam_index_] = fsm.latch_;
+      if (fsm.latch_ <= scanline_ && uint8_t(fsm.latch_ + sprite_height) > scanline_) {
+        if (fsm.poam_index_ == 0) {
+          oam_has_sprite_zero_ = true;
+        }
+        // if (fsm.latch_ == 238 || fsm.latch_ == 239) {
+        //   printf("Y=%d, S=%d\n", fsm.latch_, scanline_);
+        // }
+        fsm.state_         = State::COPY_SPRITE;
+        fsm.state_counter_ = 3;
+        fsm.soam_index_++;
+        fsm.poam_index_++;
+      } else {
+        fsm.poam_index_ += 4;
+        if (fsm.poam_index_ == 0) {
+          fsm.state_ = State::DONE;
+        }
+      }
+      break;
+
+    // Copy sprite data into seconary OAM
+    case State::COPY_SPRITE:
+      secondary_oam_.byte[fsm.soam_index_++] = fsm.latch_;
+      fsm.poam_index_++;
+
+      fsm.state_counter_--;
+      if (fsm.state_counter_ == 0) {
+
+        // Primary OAM index overflowed, therefore all 64 sprites have been evaluated
+        if (fsm.poam_index_ == 0) {
+          fsm.state_ = State::DONE;
+        }
+
+        // Secondary OAM not yet full, so continue scanning through Primary OAM
+        else if (fsm.soam_index_ < 32) {
+          fsm.state_ = State::CHECK_Y_IN_RANGE;
+        }
+
+        // Secondary OAM is full, check for sprite overflow
+        else {
+          fsm.state_ = State::OVERFLOW;
+        }
+      }
+      break;
+
+    // Check if Y val in range
+    case State::OVERFLOW:
+      if (fsm.latch_ <= scanline_ && uint8_t(fsm.latch_ + sprite_height) > scanline_) {
+        status_reg_.overflow = true;
+
+        fsm.poam_index_++;
+        fsm.state_         = State::DUMMY_READ;
+        fsm.state_counter_ = 3;
+      } else {
+        fsm.poam_index_ += 4;
+        if ((fsm.poam_index_ / 4) == 0) {
+          fsm.state_ = State::DONE;
+        } else {
+          fsm.poam_index_ = (fsm.poam_index_ & 0xFC) | ((fsm.poam_index_ + 1) & 0x03);
+        }
+      }
+
+      break;
+
+    // Dummy read
+    case State::DUMMY_READ:
+      fsm.poam_index_++;
+      fsm.state_counter_--;
+      if (fsm.state_counter_ == 0) {
+        fsm.state_ = State::OVERFLOW;
+      }
+      break;
+
+    // Do nothing; Just read next sprite, and discard result
+    case State::DONE:
+      fsm.poam_index_ += 4;
+      break;
+
+      // No default
+  }
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::startSpriteFetch() {
+  if (ctrl_reg_2_.render_enable) {
+    v_.coarse_x_scroll  = t_.coarse_x_scroll;
+    v_.nametable_select = (t_.nametable_select & 0x01) | (v_.nametable_select & 0x02);
+  }
+  num_sprites_fetched_ = 0;
+
+  // Clear old sprites
+  for (SpritePixel& pixel : sprite_line_) {
+    pixel.raw = 0;
+  }
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::fetchFirstBGTile() {
+  fetchNextBGTile();
+  pattern_sr_ <<= 16;
+  palette_sr_a_ = palette_latch_a_ ? -1 : 0;
+  palette_sr_b_ = palette_latch_b_ ? -1 : 0;
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::fetchNextBGTile() {
   const uint16_t pattern_addr = (readByte(0x2000 | (v_.raw & 0x0FFF)) << 4)    // Base tile address
                                 | ctrl_reg_1_.screen_pattern_table_addr << 12  // Pattern table
                                 | v_.fine_y_scroll;                            // Y offset (Tile slice)
@@ -618,10 +924,7 @@ void hw::ppu::PPU::fetchNextBGTile() {
   palette_latch_a_      = (palette >> at_subentry) & 0x01;
   palette_latch_b_      = (palette >> (at_subentry | 1)) & 0x01;
 
-  pattern_sr_a_ &= 0xFF00;
-  pattern_sr_b_ &= 0xFF00;
-  pattern_sr_a_ |= readByte(pattern_addr);
-  pattern_sr_b_ |= readByte(pattern_addr | 8);
+  pattern_sr_ = (pattern_sr_ & 0xFFFF0000) | fetchChrRow(pattern_addr).pixels;
 
 
   // Coarse X increment, at end of each tile
@@ -633,7 +936,8 @@ void hw::ppu::PPU::fetchNextBGTile() {
   }
 }
 
-void hw::ppu::PPU::fetchNextSprite() {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::fetchNextSprite() {
   if (num_sprites_fetched_ < (sprite_eval_fsm_.soam_index_ / 4)) {
     const Sprite& sprite = secondary_oam_.sprite[num_sprites_fetched_];
     uint8_t       tile_index;
@@ -663,10 +967,21 @@ void hw::ppu::PPU::fetchNextSprite() {
 
     readByte(0x2000 | (v_.raw & 0x0FFF));  // Garbage NT fetch
     readByte(0x2000 | (v_.raw & 0x0FFF));  // Garbage NT fetch
-    sprite_pattern_sr_a_[num_sprites_fetched_]  = readByte(pattern_addr);
-    sprite_pattern_sr_b_[num_sprites_fetched_]  = readByte(pattern_addr | 8);
-    sprite_palette_latch_[num_sprites_fetched_] = sprite.attributes;
-    sprite_x_position_[num_sprites_fetched_]    = sprite.x_position;
+    const ChrRow& row = fetchChrRow(pattern_addr);
+
+    // Draw the sprite into the line, behind any sprites already there. Pixels past the right edge are dropped
+    const SpriteAttributes attributes = sprite.attributes;
+    const uint16_t         pattern    = attributes.flip_horiz ? row.flipped : row.pixels;
+    const unsigned         width      = std::min(8, 256 - sprite.x_position);
+    for (unsigned i = 0; i < width; i++) {
+      SpritePixel& pixel = sprite_line_[sprite.x_position + i];
+      if (pixel.pixel == 0) {
+        pixel.pixel       = (pattern >> (14 - i * 2)) & 0x03;
+        pixel.palette     = attributes.palette;
+        pixel.priority    = attributes.priority;
+        pixel.sprite_zero = num_sprites_fetched_ == 0;
+      }
+    }
     num_sprites_fetched_++;
   } else {
     const uint16_t pattern_addr = 0xFF << 4                                       // Base tile address
@@ -678,7 +993,15 @@ void hw::ppu::PPU::fetchNextSprite() {
   }
 }
 
-void hw::ppu::PPU::incrementCoarseX() {
+template <class MapperT>
+const hw::ppu::PPU::ChrRow& hw::ppu::internal::PPU<MapperT>::fetchChrRow(uint16_t address) const {
+  snoopAddress(address);
+  snoopAddress(address | 8);
+  return chr_rows_[chrRowIndex(mapper()->chrOffset(address))];
+}
+
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::incrementCoarseX() {
   if (ctrl_reg_2_.render_enable) {
     v_.coarse_x_scroll += 1;
     if (v_.coarse_x_scroll == 0) {                       // Overflow
@@ -687,7 +1010,8 @@ void hw::ppu::PPU::incrementCoarseX() {
   }
 }
 
-void hw::ppu::PPU::incrementFineY() {
+template <class MapperT>
+void hw::ppu::internal::PPU<MapperT>::incrementFineY() {
   if (ctrl_reg_2_.render_enable) {
     v_.fine_y_scroll += 1;
     if (v_.fine_y_scroll == 0) {  // Overflow
@@ -698,6 +1022,10 @@ void hw::ppu::PPU::incrementFineY() {
         v_.coarse_y_scroll += 1;
       }
     }
-    mapper_->decodePPUAddress(v_.raw);
+    snoopAddress(v_.raw);
   }
 }
+
+
+#define INSTANTIATE(MapperT) template class hw::ppu::internal::PPU<MapperT>;
+NESEMU_FOR_EACH_MAPPER(INSTANTIATE)
@@ -0,0 +1,230 @@
+#include <nesemu/hw/rewind.h>
+
+#include <nesemu/hw/console.h>
+
+#include <algorithm>  // std::max
+#include <cstddef>
+#include <cstdint>
+#include <cstring>  // memcmp, memcpy
+
+
+hw::rewind::Rewind::Rewind(std::size_t budget, unsigned keyframe_interval)
+    : buffer_(budget), keyframe_interval_(std::max(keyframe_interval, 1u)) {}
+
+
+// =*=*=*=*= Capturing =*=*=*=*=
+
+void hw::rewind::Rewind::capture(console::Console* console) {
+  console->snapshot(&scratch_);
+  const std::size_t state_size = scratch_.size();
+  if (state_size > buffer_.size()) {
+    clear();  // Not even a keyframe fits
+    return;
+  }
+  if (!frames_.empty() && state_size != newest_.size()) {
+    clear();  // Another cartridge
+  }
+
+  bool        keyframe = frames_.empty() || frames_.back().position + 1 >= keyframe_interval_;
+  std::size_t size     = state_size;
+  if (!keyframe) {
+    delta_.resize(state_size);
+    size     = encode(scratch_.data(), newest_.data(), state_size, delta_.data());
+    keyframe = size >= state_size;  // Changed too much to be worth it
+  }
+
+  uint8_t* dst = reserve(keyframe ? state_size : size);
+  if (!keyframe && frames_.empty()) {
+    keyframe = true;  // Made room by dropping the frame the delta was against
+    dst      = reserve(state_size);
+  }
+  if (keyframe) {
+    size = state_size;
+  }
+
+  memcpy(dst, keyframe ? scratch_.data() : delta_.data(), size);
+  frames_.push_back({head_, size, keyframe ? 0 : frames_.back().position + 1, {buttons_[0], buttons_[1]}});
+  head_ += size;
+  newest_.swap(scratch_);
+}
+
+uint8_t* hw::rewind::Rewind::reserve(std::size_t size) {
+  while (!frames_.empty()) {
+    const std::size_t tail = frames_.front().offset;
+    if (head_ > tail) {  // Frames are in [tail, head_), so there's room after them, or before them
+      if (buffer_.size() - head_ >= size) {
+        break;
+      }
+      head_ = 0;
+    } else if (tail - head_ >= size) {  // Frames are in [tail, end) and [0, head_), so there's only room between
+      break;
+    } else {
+      frames_.pop_front();
+      while (!frames_.empty() && frames_.front().position != 0) {
+        frames_.pop_front();
+      }
+    }
+  }
+
+  if (frames_.empty()) {
+    head_ = 0;
+  }
+  return buffer_.data() + head_;
+}
+
+// Each changed run is a skip (unchanged bytes since the last run) and a length, then the run XORed with the previous
+// frame. Runs carry on through fewer than 4 unchanged bytes, as a new run would take 4 to describe. Returns the size of
+// the delta, or at least the size of the state if the delta wouldn't be any smaller
+std::size_t hw::rewind::Rewind::encode(const uint8_t* state,
+                                       const uint8_t* previous,
+                                       std::size_t    size,
+                                       uint8_t*       delta) {
+  static constexpr std::size_t MAX_RUN = 0xFFFF;
+  static constexpr std::size_t HEADER  = 2 * sizeof(uint16_t);
+
+  std::size_t out = 0;
+  std::size_t pos = 0;
+  while (pos < size) {
+    // Unchanged bytes, a word at a time
+    const std::size_t start = pos;
+    while (pos + sizeof(uint64_t) <= size && memcmp(state + pos, previous + pos, sizeof(uint64_t)) == 0) {
+      pos += sizeof(uint64_t);
+    }
+    while (pos < size && state[pos] == previous[pos]) {
+      pos++;
+    }
+    if (pos == size) {
+      break;
+    }
+
+    // Changed bytes
+    const std::size_t run_start = pos;
+    std::size_t       unchanged = 0;
+    while (pos < size && unchanged < HEADER && pos - run_start < MAX_RUN) {
+      unchanged = (state[pos] == previous[pos]) ? unchanged + 1 : 0;
+      pos++;
+    }
+    pos -= unchanged;
+
+    std::size_t       skip   = run_start - start;
+    const std::size_t length = pos - run_start;
+    for (; skip > MAX_RUN; skip -= MAX_RUN) {
+      if (out + HEADER > size) {
+        return size;
+      }
+      const uint16_t header[2] = {MAX_RUN, 0};
+      memcpy(delta + out, header, HEADER);
+      out += HEADER;
+    }
+    if (out + HEADER + length > size) {
+      return size;
+    }
+    const uint16_t header[2] = {static_cast<uint16_t>(skip), static_cast<uint16_t>(length)};
+    memcpy(delta + out, header, HEADER);
+    out += HEADER;
+    for (std::size_t i = run_start; i < pos; i++) {
+      delta[out++] = state[i] ^ previous[i];
+    }
+  }
+  return out;
+}
+
+// XORing works both ways, so this turns the previous frame into the delta's frame, and the delta's frame back again
+void hw::rewind::Rewind::apply(const uint8_t* delta, std::size_t delta_size, uint8_t* state) {
+  std::size_t pos = 0;
+  for (std::size_t in = 0; in < delta_size;) {
+    uint16_t header[2];
+    memcpy(header, delta + in, sizeof(header));
+    in += sizeof(header);
+
+    pos += header[0];
+    for (unsigned i = 0; i < header[1]; i++) {
+      state[pos++] ^= delta[in++];
+    }
+  }
+}
+
+
+// =*=*=*=*= Rewinding =*=*=*=*=
+
+int hw::rewind::Rewind::stepBack(console::Console* console) {
+  if (frames_.size() < 2) {
+    return 1;
+  }
+
+  // The dropped frame's space is reused, and nothing newer can be using the space before it
+  const Frame dropped = frames_.back();
+  frames_.pop_back();
+  head_ = dropped.offset;
+
+  if (dropped.position != 0) {
+    apply(buffer_.data() + dropped.offset, dropped.size, newest_.data());
+  } else {
+    decode(frames_.size() - 1, &newest_);
+  }
+  return console->restore(newest_);
+}
+
+int hw::rewind::Rewind::load(console::Console* console, std::size_t age) {
+  if (age >= frames_.size()) {
+    return 1;
+  }
+  if (age == 0) {
+    return console->restore(newest_);
+  }
+  decode(frames_.size() - 1 - age, &scratch_);
+  return console->restore(scratch_);
+}
+
+int hw::rewind::Rewind::replay(console::Console* console) {
+  if (load(console, 1)) {
+    return 1;
+  }
+
+  buttons_[0] = frames_.back().input[0];
+  buttons_[1] = frames_.back().input[1];
+  replaying_  = true;
+  console->runFrame();
+  replaying_ = false;
+  return console->restore(newest_);
+}
+
+void hw::rewind::Rewind::decode(std::size_t index, std::vector<uint8_t>* state) const {
+  const std::size_t keyframe = index - frames_[index].position;
+  const uint8_t*    data     = buffer_.data() + frames_[keyframe].offset;
+  state->assign(data, data + frames_[keyframe].size);
+
+  for (std::size_t i = keyframe + 1; i <= index; i++) {
+    apply(buffer_.data() + frames_[i].offset, frames_[i].size, state->data());
+  }
+}
+
+void hw::rewind::Rewind::clear() {
+  frames_.clear();
+  head_ = 0;
+}
+
+
+// =*=*=*=*= Input =*=*=*=*=
+
+uint8_t hw::rewind::Rewind::poll(uint8_t port) {
+  if (!replaying_) {
+    buttons_[port - 1] = input_ ? input_->poll(port) : 0;
+  }
+  return buttons_[port - 1];
+}
+
+
+// =*=*=*=*= Misc =*=*=*=*=
+
+std::size_t hw::rewind::Rewind::keyframes() const {
+  return std::count_if(frames_.begin(), frames_.end(), [](const Frame& frame) { return frame.position == 0; });
+}
+
+std::size_t hw::rewind::Rewind::bytesUsed() const {
+  std::size_t used = 0;
+  for (const Frame& frame : frames_) {
+    used += frame.size;
+  }
+  return used;
+}
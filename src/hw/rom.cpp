@@ -56,7 +56,7 @@ int hw::rom::parseFromFile(std::string filename, Rom* rom) {
   }
 
   if (rom->header.has_battery) {
-    rom->expansion = new uint8_t[1][0x2000];
+    rom->expansion = new uint8_t[1][0x2000]();  // Zeroed, so every console loading the rom starts the same
 
     // TODO: Handle trainers better (https://forums.nesdev.org/viewtopic.php?t=3657)
     if (rom->header.has_trainer) {
@@ -74,7 +74,7 @@ int hw::rom::parseFromFile(std::string filename, Rom* rom) {
   file.read(reinterpret_cast<char*>(rom->prg), rom->header.prg_rom_size * 16 * 1024);
 
   if (rom->header.chr_rom_size == 0) {
-    rom->chr = new uint8_t[1][8 * 1024];  // Cartridge uses CHR RAM
+    rom->chr = new uint8_t[1][8 * 1024]();  // Cartridge uses CHR RAM. Zeroed, as above
   } else {
     rom->chr = new uint8_t[rom->header.chr_rom_size][8 * 1024];
     file.read(reinterpret_cast<char*>(rom->chr), rom->header.chr_rom_size * 8 * 1024);
@@ -4,17 +4,19 @@
 #include <nesemu/hw/clock.h>
 #include <nesemu/hw/cpu.h>
 #include <nesemu/hw/joystick.h>
-#include <nesemu/hw/mapper/mapper_base.h>
+#include <nesemu/hw/mapper/mapper_types.h>
 #include <nesemu/hw/ppu.h>
-#include <nesemu/logger.h>
 
+#include <algorithm>  // std::min, std::max
 
-void hw::system_bus::SystemBus::connectChips(clock::CPUClock*    clock,
-                                             apu::APU*           apu,
-                                             cpu::CPU*           cpu,
-                                             ppu::PPU*           ppu,
-                                             joystick::Joystick* joy_1,
-                                             joystick::Joystick* joy_2) {
+
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::connectChips(clock::CPUClock*             clock,
+                                                      apu::APU*                    apu,
+                                                      cpu::CPU<MapperT>*           cpu,
+                                                      ppu::internal::PPU<MapperT>* ppu,
+                                                      joystick::Joystick*          joy_1,
+                                                      joystick::Joystick*          joy_2) {
   clock_ = clock;
   apu_   = apu;
   cpu_   = cpu;
@@ -23,115 +25,232 @@ void hw::system_bus::SystemBus::connectChips(clock::CPUClock*    clock,
   joy_2_ = joy_2;
 }
 
-void hw::system_bus::SystemBus::loadCart(mapper::Mapper* mapper, uint8_t* prg_rom, uint8_t* expansion_ram) {
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::loadCart(MapperT* mapper, uint8_t* expansion_ram) {
   mapper_        = mapper;
-  prg_rom_       = prg_rom;
   expansion_ram_ = expansion_ram;
+  mapMemory();
 }
 
 
-bool hw::system_bus::SystemBus::hasIRQ() const {
-  return mapper_->hasIRQ() || apu_->hasIRQ();
+template <class MapperT>
+uint32_t hw::system_bus::SystemBus<MapperT>::statusStableCycles() const {
+  syncPPU();
+  return ppu_->statusStableDots() / 3;
 }
 
-bool hw::system_bus::SystemBus::hasNMI() const {
-  return ppu_->hasNMI();
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::sync() {
+  syncPPU();
+  syncAPU();
 }
 
-uint8_t hw::system_bus::SystemBus::read(uint16_t address) const {
-  static uint8_t data;
-  address &= 0xFFFF;
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::syncPPU() const {
+  ppu_->run((cycles_ - ppu_cycles_) * 3);
+  ppu_cycles_ = cycles_;
+  setLine(NMI_PPU, ppu_->hasNMI());
+  setLine(IRQ_MAPPER, mapper_->hasIRQ());  // Mappers which watch the PPU bus count scanlines with it
+
+  const uint32_t dots = mapper_->snoopsPPU() ? 0 : ppu_->dotsUntilEvent();
+  scheduler_.schedule(scheduler::Event::PPU, cycles_ + std::max<uint32_t>((dots + 2) / 3, 1));
+}
 
-  if (address < 0x2000) {  // Stack and RAM
-    data = ram_[address & 0x07FF];
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::syncAPU() const {
+  apu_->run(cycles_ - apu_cycles_);
+  apu_cycles_ = cycles_;
+  setLine(IRQ_APU, apu_->hasIRQ());
+
+  const uint32_t cycles = std::min(apu_->cyclesUntilEvent(), MAX_APU_LAG);
+  scheduler_.schedule(scheduler::Event::APU, cycles_ + std::max<uint32_t>(cycles, 1));
+}
+
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::runEvents() {
+  if (scheduler_.due(scheduler::Event::PPU, cycles_)) {
+    syncPPU();
+  }
+  if (scheduler_.due(scheduler::Event::APU, cycles_)) {
+    syncAPU();
   }
+}
+
+// =*=*=*=*= Save States =*=*=*=*=
 
-  else if (address < 0x4000) {  // PPU Registers
-    data = ppu_->readRegister((address & 0x0007) | 0x2000);
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::saveState(state::Writer* out) const {
+  out->putBytes(ram_, sizeof(ram_));
+  if (expansion_ram_) {
+    out->putBytes(expansion_ram_, 0x2000);
   }
+  out->put(open_bus_);
+  out->put(cycles_);
+}
 
-  else if (address < 0x4014) {  // Sound Registers
-    // Open bus, these registers are write-only
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::loadState(state::Reader* in) {
+  in->getBytes(ram_, sizeof(ram_));
+  if (expansion_ram_) {
+    in->getBytes(expansion_ram_, 0x2000);
   }
+  in->get(open_bus_);
+  in->get(cycles_);
 
-  else if (address == 0x4014) {  // PPU DMA Access
-    // Open bus, cannot read DMA register
+  ppu_cycles_ = cycles_;
+  apu_cycles_ = cycles_;
+  mapPRG();
+  sync();
+}
+
+// =*=*=*=*= Memory Map =*=*=*=*=
+
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::mapMemory() {
+  for (unsigned page = 0x00; page < 0x100; page++) {
+    ReadPage&  r = read_map_[page];
+    WritePage& w = write_map_[page];
+
+    if (page < 0x20) {  // Stack and RAM
+      r = {ram_ + ((page & 0x07) << 8), nullptr};
+      w = {ram_ + ((page & 0x07) << 8), nullptr};
+    }
+
+    else if (page < 0x40) {  // PPU Registers
+      r = {nullptr, &SystemBus::readPPU};
+      w = {nullptr, &SystemBus::writePPU};
+    }
+
+    else if (page == 0x40) {  // APU, joysticks and DMA
+      r = {nullptr, &SystemBus::readIO};
+      w = {nullptr, &SystemBus::writeIO};
+    }
+
+    else if (page < 0x60) {  // Mapper or Expansion Modules, ie. Famicom Disk System
+      r = {nullptr, &SystemBus::readMapper};
+      w = {nullptr, &SystemBus::writeMapper};
+    }
+
+    else if (page < 0x80) {  // Cartridge RAM
+      if (expansion_ram_) {
+        r = {expansion_ram_ + ((page - 0x60) << 8), nullptr};
+        w = {expansion_ram_ + ((page - 0x60) << 8), nullptr};
+      } else {
+        r = {nullptr, &SystemBus::readNoCartRAM};
+        w = {nullptr, &SystemBus::writeNone};
+      }
+    }
+
+    else {  // Cartridge ROM. Read pages are filled by mapPRG()
+      w = {nullptr, &SystemBus::writeMapper};
+    }
   }
 
-  else if (address == 0x4015) {  // Sound Channel Switch
-    data = apu_->readRegister(address);
+  mapPRG();
+}
+
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::mapPRG() {
+  prg_generation_++;
+  for (unsigned page = 0x80; page < 0x100; page++) {
+    read_map_[page] = {mapper_->prg(page << 8), nullptr};
   }
+}
 
-  else if (address == 0x4016) {  // Joystick 1
-    data = joy_1_->read();
+
+// =*=*=*=*= Memory-Mapped IO =*=*=*=*=
+
+template <class MapperT>
+uint8_t hw::system_bus::SystemBus<MapperT>::readOpenBus(uint16_t /*address*/) const {
+  return open_bus_;
+}
+
+template <class MapperT>
+uint8_t hw::system_bus::SystemBus<MapperT>::readPPU(uint16_t address) const {
+  syncPPU();
+  scheduler_.schedule(scheduler::Event::PPU, cycles_ + 1);  // The read may have changed when the next event is
+  const uint8_t data = ppu_->readRegister((address & 0x0007) | 0x2000);
+  setLine(NMI_PPU, ppu_->hasNMI());
+  return data;
+}
+
+template <class MapperT>
+uint8_t hw::system_bus::SystemBus<MapperT>::readIO(uint16_t address) const {
+  if (address < 0x4014) {  // Sound Registers
+    return open_bus_;      // Open bus, these registers are write-only
   }
 
-  else if (address == 0x4017) {  // Joystick 2
-    data = joy_2_->read();
+  else if (address == 0x4014) {  // PPU DMA Access
+    return open_bus_;            // Open bus, cannot read DMA register
   }
 
-  else if (address < 0x4100) {  // Unallocated I/O space
-    // Open bus
+  else if (address == 0x4015) {  // Sound Channel Switch
+    syncAPU();
+    scheduler_.schedule(scheduler::Event::APU, cycles_ + 1);  // The read may have changed when the next event is
+    const uint8_t data = apu_->readRegister(address);
+    setLine(IRQ_APU, apu_->hasIRQ());
+    return data;
   }
 
-  else if (address < 0x6000) {  // Mapper or Expansion Modules, ie. Famicom Disk System
-    // Open bus if no mapper
-    mapper_->read(address, data);
+  else if (address == 0x4016) {  // Joystick 1
+    return joy_1_->read();
   }
 
-  else if (address < 0x8000) {  // Cartridge RAM
-    if (expansion_ram_) {
-      data = expansion_ram_[address - 0x6000];
-    } else {
-      // No cartridge RAM
-      // Depending on the mapper, this should actually be open bus sometimes
-      data = 0;
-    }
+  else if (address == 0x4017) {  // Joystick 2
+    return joy_2_->read();
   }
 
-  else {  // Cartridge ROM
-    data = prg_rom_[mapper_->decodeCPUAddress(address)];
+  else {               // Unallocated I/O space
+    return open_bus_;  // Open bus
   }
+}
 
-  logger::log<logger::DEBUG_BUS>("Read $%02X from $(%04X)\n", data, address);
+template <class MapperT>
+uint8_t hw::system_bus::SystemBus<MapperT>::readMapper(uint16_t address) const {
+  // Open bus if no mapper
+  uint8_t data = open_bus_;
+  mapper_->read(address, data);
   return data;
 }
 
+template <class MapperT>
+uint8_t hw::system_bus::SystemBus<MapperT>::readNoCartRAM(uint16_t /*address*/) const {
+  // No cartridge RAM
+  // Depending on the mapper, this should actually be open bus sometimes
+  return 0;
+}
 
-void hw::system_bus::SystemBus::write(uint16_t address, uint8_t data) {
-  logger::log<logger::DEBUG_BUS>("Write $%02X to $(%04X)\n", data, address);
-  address &= 0xFFFF;
 
-  if (address < 0x2000) {  // Stack and RAM
-    ram_[address & 0x07FF] = data;
-  }
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::writeNone(uint16_t /*address*/, uint8_t /*data*/) {
+  ;
+}
 
-  else if (address < 0x4000) {  // PPU Registers
-    ppu_->writeRegister((address & 0x0007) | 0x2000, data);
-  }
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::writePPU(uint16_t address, uint8_t data) {
+  syncPPU();
+  scheduler_.schedule(scheduler::Event::PPU, cycles_ + 1);  // The write may have changed when the next event is
+  ppu_->writeRegister((address & 0x0007) | 0x2000, data);
+  setLine(NMI_PPU, ppu_->hasNMI());
+}
 
-  else if (address < 0x4014) {  // Sound Registers
-    apu_->writeRegister(address, data);
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::writeIO(uint16_t address, uint8_t data) {
+  if (address < 0x4014) {  // Sound Registers
+    writeAPU(address, data);
   }
 
   else if (address == 0x4014) {  // PPU DMA Access
-    if (data * 0x100 < 0x2000) {
-      ppu_->spriteDMAWrite(ram_ + (data * 0x100));  // Internal RAM
-    } else if (data * 0x100 < 0x6000) {
-      ;  // Cannot DMA from MMIO
-    } else if (data * 0x100 < 0x8000) {
-      if (expansion_ram_) {
-        ppu_->spriteDMAWrite(expansion_ram_ + (data * 0x100) - 0x6000);
-      } else {
-        ;  // No cartridge RAM
-      }
+    if (const uint8_t* mem = read_map_[data].mem) {
+      syncPPU();
+      ppu_->spriteDMAWrite(mem);  // RAM, cartridge RAM or ROM
     } else {
-      ppu_->spriteDMAWrite(prg_rom_ + (data * 0x100) - 0x8000);  // Cartridge ROM
+      ;  // Cannot DMA from MMIO
     }
   }
 
   else if (address == 0x4015) {  // Sound Channel Switch
-    apu_->writeRegister(address, data);
+    writeAPU(address, data);
   }
 
   else if (address == 0x4016) {  // Joystick Strobe
@@ -140,45 +259,66 @@ void hw::system_bus::SystemBus::write(uint16_t address, uint8_t data) {
   }
 
   else if (address == 0x4017) {  // APU frame counter
-    apu_->writeRegister(address, data);
+    writeAPU(address, data);
   }
 
   else if (address == 0x4020) {  // Unused
     ;
   }
 
-  else if (address < 0x6000) {  // Mapper or Expansion Modules, ie. Famicom Disk System
-    mapper_->write(address, data);
+  else {  // Mapper or Expansion Modules, ie. Famicom Disk System
+    writeMapper(address, data);
   }
+}
 
-  else if (address < 0x8000) {  // Cartridge RAM
-    if (expansion_ram_) {
-      expansion_ram_[address - 0x6000] = data;
-    } else {
-      ;  // No cartridge RAM
-    }
-  }
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::writeAPU(uint16_t address, uint8_t data) {
+  syncAPU();
+  scheduler_.schedule(scheduler::Event::APU, cycles_ + 1);  // The write may have changed when the next event is
+  apu_->writeRegister(address, data);
+  setLine(IRQ_APU, apu_->hasIRQ());
+}
 
-  else {  // Mapper
-    mapper_->write(address, data);
-  }
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::writeMapper(uint16_t address, uint8_t data) {
+  syncPPU();
+  mapper_->write(address, data);
+  setLine(IRQ_MAPPER, mapper_->hasIRQ());
+  mapPRG();
 }
 
-void hw::system_bus::SystemBus::clock() {
+
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::clock() {
+  cycles_++;
   mapper_->clock();
-  ppu_->clock();
-  ppu_->clock();
-  ppu_->clock();
-  apu_->clock();
+  if (cycles_ >= scheduler_.next()) {
+    runEvents();
+  }
   // Note: Do not clock the CPU - This function is clocked by the CPU itself
 
-  clock_->sleep();
+  clock_->tick();
 }
 
-bool hw::system_bus::SystemBus::hasDMCDMA() const {
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::skip(uint32_t cycles) {
+  cycles_ += cycles;
+  clock_->tick(cycles);
+}
+
+template <class MapperT>
+bool hw::system_bus::SystemBus<MapperT>::hasDMCDMA() const {
   return apu_->DMAActive();
 }
 
-void hw::system_bus::SystemBus::doDMCDMA() {
+template <class MapperT>
+void hw::system_bus::SystemBus<MapperT>::doDMCDMA() {
+  syncAPU();
   apu_->DMAPush(read(apu_->DMAAddr()));
+  setLine(IRQ_APU, apu_->hasIRQ());
+  scheduler_.schedule(scheduler::Event::APU, cycles_ + 1);  // The DMA may have changed when the next event is
 }
+
+
+#define INSTANTIATE(MapperT) template class hw::system_bus::SystemBus<MapperT>;
+NESEMU_FOR_EACH_MAPPER(INSTANTIATE)
@@ -1,4 +1,181 @@
 #include <nesemu/logger.h>
 
+#include <algorithm>  // std::min
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
 
-logger::Level logger::level = static_cast<logger::Level>(logger::ERROR | logger::WARNING | logger::INFO);
+
+namespace {
+
+// Queued messages from a single thread. Only that thread pushes, and only the writer pops, so neither ever waits for
+// the other
+class Queue {
+public:
+  static constexpr std::size_t CAPACITY    = 2048;  // Messages, must be a power of 2
+  static constexpr std::size_t MAX_MESSAGE = 256;   // Bytes, longer messages are truncated
+
+  bool push(const char* format, va_list args) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) == CAPACITY) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    Message&  message = messages_[head & (CAPACITY - 1)];
+    const int size    = vsnprintf(message.text, MAX_MESSAGE, format, args);
+    message.size      = std::min<std::size_t>(size < 0 ? 0 : size, MAX_MESSAGE - 1);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  // Write everything queued so far. Returns false if there was nothing to write
+  bool write(std::FILE* file) {
+    const std::size_t head = head_.load(std::memory_order_acquire);
+    std::size_t       tail = tail_.load(std::memory_order_relaxed);
+    if (head == tail) {
+      return false;
+    }
+
+    for (; tail != head; tail++) {
+      const Message& message = messages_[tail & (CAPACITY - 1)];
+      fwrite(message.text, 1, message.size, file);
+    }
+    if (const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed)) {
+      fprintf(file, "\n[%llu debug messages dropped]\n", static_cast<unsigned long long>(dropped));
+    }
+    tail_.store(tail, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const { return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire); }
+
+  std::atomic<bool> closed = {false};  // The thread has exited, so once empty, the queue can go
+
+private:
+  struct Message {
+    std::size_t size;
+    char        text[MAX_MESSAGE];
+  };
+
+  std::vector<Message>     messages_ = std::vector<Message>(CAPACITY);
+  std::atomic<std::size_t> head_     = {0};  // Next message to push
+  std::atomic<std::size_t> tail_     = {0};  // Next message to write
+  std::atomic<uint64_t>    dropped_  = {0};
+};
+
+
+// Writes every thread's queued messages to stdout, from a thread of its own. Started by the first queued message, and
+// writes everything left when the program exits
+class Writer {
+public:
+  ~Writer() {
+    if (thread_.joinable()) {
+      stop_.store(true, std::memory_order_release);
+      thread_.join();
+    }
+  }
+
+  std::shared_ptr<Queue> add() {
+    std::shared_ptr<Queue>      queue = std::make_shared<Queue>();
+    std::lock_guard<std::mutex> lock(mutex_);
+    queues_.push_back(queue);
+    if (!thread_.joinable()) {
+      thread_ = std::thread(&Writer::run, this);
+    }
+    return queue;
+  }
+
+private:
+  std::mutex                          mutex_;
+  std::vector<std::shared_ptr<Queue>> queues_;
+  std::thread                         thread_;
+  std::atomic<bool>                   stop_ = {false};
+
+  static constexpr auto IDLE = std::chrono::milliseconds(1);
+
+  void run() {
+    bool stopping = false;
+    while (!stopping) {
+      stopping = stop_.load(std::memory_order_acquire);  // Still write everything queued before stopping
+
+      bool wrote = false;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = queues_.begin(); it != queues_.end();) {
+          const bool closed = (*it)->closed.load(std::memory_order_acquire);
+          wrote |= (*it)->write(stdout);
+          it = (closed && (*it)->empty()) ? queues_.erase(it) : it + 1;
+        }
+      }
+
+      if (wrote) {
+        fflush(stdout);
+      } else if (!stopping) {
+        std::this_thread::sleep_for(IDLE);
+      }
+    }
+  }
+};
+
+Writer writer;
+
+
+// The calling thread's queue, made by its first queued message
+class Producer {
+public:
+  ~Producer() {
+    if (queue_) {
+      queue_->closed.store(true, std::memory_order_release);
+    }
+  }
+
+  Queue* get() {
+    if (!queue_) {
+      queue_ = writer.add();
+    }
+    return queue_.get();
+  }
+
+  Queue* peek() const { return queue_.get(); }
+
+private:
+  std::shared_ptr<Queue> queue_;
+};
+
+thread_local Producer producer;
+
+}  // namespace
+
+
+void logger::flush() {
+  const Queue* queue = producer.peek();
+  while (queue && !queue->empty()) {
+    std::this_thread::yield();
+  }
+  fflush(stdout);
+}
+
+void logger::internal::print(const char* format, ...) {
+  if (producer.peek()) {
+    flush();
+  }
+
+  va_list args;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+}
+
+void logger::internal::queue(const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  producer.get()->push(format, args);
+  va_end(args);
+}
@@ -0,0 +1,25 @@
+#include <nesemu/ui/keyboard.h>
+
+#include <SDL2/SDL_keyboard.h>
+
+// TODO: Change controller 2 mapping
+constexpr int MAPPING_A[2]     = {SDL_SCANCODE_Z, SDL_SCANCODE_Z};
+constexpr int MAPPING_B[2]     = {SDL_SCANCODE_X, SDL_SCANCODE_X};
+constexpr int MAPPING_SEL[2]   = {SDL_SCANCODE_SPACE, SDL_SCANCODE_SPACE};
+constexpr int MAPPING_START[2] = {SDL_SCANCODE_RETURN, SDL_SCANCODE_RETURN};
+constexpr int MAPPING_UP[2]    = {SDL_SCANCODE_UP, SDL_SCANCODE_UP};
+constexpr int MAPPING_DOWN[2]  = {SDL_SCANCODE_DOWN, SDL_SCANCODE_DOWN};
+constexpr int MAPPING_LEFT[2]  = {SDL_SCANCODE_LEFT, SDL_SCANCODE_LEFT};
+constexpr int MAPPING_RIGHT[2] = {SDL_SCANCODE_RIGHT, SDL_SCANCODE_RIGHT};
+
+
+uint8_t ui::Keyboard::poll(uint8_t port) {
+  if (!state_) {
+    state_ = SDL_GetKeyboardState(nullptr);
+  }
+
+  const unsigned i = port - 1;
+  return (state_[MAPPING_A[i]] << 0) | (state_[MAPPING_B[i]] << 1) | (state_[MAPPING_SEL[i]] << 2)
+         | (state_[MAPPING_START[i]] << 3) | (state_[MAPPING_UP[i]] << 4) | (state_[MAPPING_DOWN[i]] << 5)
+         | (state_[MAPPING_LEFT[i]] << 6) | (state_[MAPPING_RIGHT[i]] << 7);
+}
@@ -1,8 +1,8 @@
 #include <nesemu/ui/nametable_viewer.h>
 
+#include <nesemu/hw/palette.h>
 #include <nesemu/hw/ppu.h>
 #include <nesemu/logger.h>
-#include <nesemu/temp_mapping.h>
 
 
 void ui::NametableViewer::update() {
@@ -10,9 +10,6 @@ void ui::NametableViewer::update() {
     return;
   }
 
-  // Screen buffer
-  static uint32_t* pixels = new uint32_t[TEXTURE_WIDTH * TEXTURE_HEIGHT];
-
   // Iterate over every 8x8 tile in the 2x2 nametable array
   for (uint8_t row = 0; row < 60; row++) {
     for (uint8_t col = 0; col < 64; col++) {
@@ -24,7 +21,7 @@ void ui::NametableViewer::update() {
 
       // Fine the index into the pattern table from the nametable
       const uint16_t offset       = c | r << 5 | nt << 10;
-      const uint16_t pattern_addr = (ppu_->readByte(0x2000 | offset) << 4)                // Base tile address
+      const uint16_t pattern_addr = (ppu_->peekByte(0x2000 | offset) << 4)                // Base tile address
                                     | ppu_->ctrl_reg_1_.screen_pattern_table_addr << 12;  // Pattern table
 
       // Index into attribute table (4x4 tile palette)
@@ -32,15 +29,15 @@ void ui::NametableViewer::update() {
       const uint8_t  at_subentry = (c & 2) | ((r & 2) << 1);
 
       // Get palette from attribute table
-      const uint8_t full_palette = ppu_->readByte(0x23C0 | at_entry);
+      const uint8_t full_palette = ppu_->peekByte(0x23C0 | at_entry);
       const uint8_t palette_a    = (full_palette >> at_subentry) & 0x01;
       const uint8_t palette_b    = (full_palette >> (at_subentry | 1)) & 0x01;
       const uint8_t sub_palette  = palette_a | (palette_b << 1);
 
       // Tile row
       for (uint8_t i = 0; i < 8; i++) {
-        const uint8_t ptrn_a = ppu_->readByte((pattern_addr + i));
-        const uint8_t ptrn_b = ppu_->readByte((pattern_addr + i) | 8);
+        const uint8_t ptrn_a = ppu_->peekByte((pattern_addr + i));
+        const uint8_t ptrn_b = ppu_->peekByte((pattern_addr + i) | 8);
 
         // Tile col
         for (uint8_t j = 0; j < 8; j++) {
@@ -53,7 +50,8 @@ void ui::NametableViewer::update() {
             palette_addr = pixel | (sub_palette << 2);
           }
 
-          pixels[(row * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] = decodeColor(ppu_->readByte(0x3F00 | palette_addr));
+          pixels_[(row * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] =
+              (*colors_)[ppu_->peekByte(0x3F00 | palette_addr) & 0x3F];
         }
       }
     }
@@ -67,18 +65,18 @@ void ui::NametableViewer::update() {
                      + (ppu_->t_.nametable_select & 0x02) * 240 / 2;
 
   for (unsigned col = x; col < x + 255; col++) {
-    pixels[y * TEXTURE_WIDTH + (col % TEXTURE_WIDTH)] = box_color;
+    pixels_[y * TEXTURE_WIDTH + (col % TEXTURE_WIDTH)] = box_color;
   }
   for (unsigned row = y; row < y + 239; row++) {
-    pixels[(row % TEXTURE_HEIGHT) * TEXTURE_WIDTH + x]                         = box_color;
-    pixels[(row % TEXTURE_HEIGHT) * TEXTURE_WIDTH + (x + 255) % TEXTURE_WIDTH] = box_color;
+    pixels_[(row % TEXTURE_HEIGHT) * TEXTURE_WIDTH + x]                         = box_color;
+    pixels_[(row % TEXTURE_HEIGHT) * TEXTURE_WIDTH + (x + 255) % TEXTURE_WIDTH] = box_color;
   }
   for (unsigned col = x; col < x + 255; col++) {
-    pixels[((y + 239) % TEXTURE_HEIGHT) * TEXTURE_WIDTH + (col % TEXTURE_WIDTH)] = box_color;
+    pixels_[((y + 239) % TEXTURE_HEIGHT) * TEXTURE_WIDTH + (col % TEXTURE_WIDTH)] = box_color;
   }
 
   // Draw the nametable to the screen, with locked aspect ratio TEXTURE_HEIGHT/TEXTURE_WIDTH
-  SDL_UpdateTexture(texture_, nullptr, pixels, TEXTURE_WIDTH * sizeof(uint32_t));
+  SDL_UpdateTexture(texture_, nullptr, pixels_.data(), TEXTURE_WIDTH * sizeof(uint32_t));
   SDL_RenderClear(renderer_);
   SDL_Rect dest;
   if (width_ * TEXTURE_HEIGHT < height_ * TEXTURE_WIDTH) {
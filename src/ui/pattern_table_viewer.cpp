@@ -1,8 +1,8 @@
 #include <nesemu/ui/pattern_table_viewer.h>
 
+#include <nesemu/hw/palette.h>
 #include <nesemu/hw/ppu.h>
 #include <nesemu/logger.h>
-#include <nesemu/temp_mapping.h>
 
 
 void ui::PatternTableViewer::update() {
@@ -10,28 +10,24 @@ void ui::PatternTableViewer::update() {
     return;
   }
 
-  // Screen buffer
-  static uint32_t* pixels = new uint32_t[TEXTURE_WIDTH * TEXTURE_HEIGHT];
-
   // Iterate over every tile in the first pattern table
   for (uint8_t table = 0; table < 2; table++) {
     for (uint8_t row = 0; row < 16; row++) {
       for (uint8_t col = 0; col < 16; col++) {
-        const uint16_t pattern_addr = (row * 16 + col) * 8  // Base tile address
-                                      | table << 12;        // Pattern table
+        const uint16_t pattern_addr = (row * 16 + col) * 16  // Base tile address
+                                      | table << 12;         // Pattern table
 
         // Tile row
         for (uint8_t i = 0; i < 8; i++) {
-          const uint8_t ptrn_a = ppu_->readByte((pattern_addr + i));
-          const uint8_t ptrn_b = ppu_->readByte((pattern_addr + i) | 8);
+          const uint16_t pattern = ppu_->chrRow(pattern_addr + i).pixels;
 
           // Tile col
           for (uint8_t j = 0; j < 8; j++) {
-            const uint8_t  pixel        = ((ptrn_a >> (7 - j)) & 0x01) | (((ptrn_b >> (7 - j)) << 1) & 0x02);
+            const uint8_t  pixel        = (pattern >> (14 - j * 2)) & 0x03;
             const uint16_t palette_addr = pixel | (palette_ << 2);
 
-            pixels[((table * 16 + row) * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] = decodeColor(
-                ppu_->readByte(0x3F00 | palette_addr));
+            pixels_[((table * 16 + row) * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] =
+                (*colors_)[ppu_->peekByte(0x3F00 | palette_addr) & 0x3F];
           }
         }
       }
@@ -39,7 +35,7 @@ void ui::PatternTableViewer::update() {
   }
 
   // Draw the pattern table to the screen, with locked aspect ratio TEXTURE_HEIGHT/TEXTURE_WIDTH
-  SDL_UpdateTexture(texture_, nullptr, pixels, TEXTURE_WIDTH * sizeof(uint32_t));
+  SDL_UpdateTexture(texture_, nullptr, pixels_.data(), TEXTURE_WIDTH * sizeof(uint32_t));
   SDL_RenderClear(renderer_);
   SDL_Rect dest;
   if (width_ * TEXTURE_HEIGHT < height_ * TEXTURE_WIDTH) {
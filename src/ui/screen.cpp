@@ -1,9 +1,12 @@
 #include <nesemu/ui/screen.h>
 
-#include <cstdio>  // snprintf
+#include <nesemu/logger.h>
 
+#include <algorithm>  // std::clamp, std::min
+#include <cstdio>     // snprintf
 
-void ui::Screen::update(const uint32_t* pixels) {
+
+void ui::Screen::update(const uint16_t* pixels) {
   if (!visible_) {
     return;
   }
@@ -14,14 +17,30 @@ void ui::Screen::update(const uint32_t* pixels) {
 
   frame_++;
   if ((frame_ % 10) == 0) {
-    static const size_t MAX_SIZE = snprintf(nullptr, 0, "%s | 1000.00 FPS", title_.c_str()) + 1;
-    static char*        BUFFER   = new char[MAX_SIZE];
+    char fps[32];
+    snprintf(fps, sizeof(fps), " | %.1f FPS", 1.0 / fps_buffer_.avg());
+    SDL_SetWindowTitle(window_, (title_ + fps).c_str());
+  }
 
-    snprintf(BUFFER, MAX_SIZE, "%s | %.1f FPS", title_.c_str(), 1.0 / fps_buffer_.avg());
-    SDL_SetWindowTitle(window_, BUFFER);
+  // Resize the texture if the window has changed scale
+  const unsigned scale = fitScale();
+  if (scale != scale_) {
+    SDL_Texture* texture = SDL_CreateTexture(renderer_,
+                                             SDL_PIXELFORMAT_ARGB8888,
+                                             SDL_TEXTUREACCESS_STREAMING,
+                                             TEXTURE_WIDTH * scale,
+                                             TEXTURE_HEIGHT * scale);
+    if (texture) {
+      SDL_DestroyTexture(texture_);
+      texture_ = texture;
+      scale_   = scale;
+    } else {
+      logger::log<logger::WARNING>("Could not resize texture: %s\n", SDL_GetError());
+    }
   }
 
-  SDL_UpdateTexture(texture_, nullptr, pixels, TEXTURE_WIDTH * sizeof(uint32_t));
+  colors_->convert(pixels, rgb_.data(), scale_);
+  SDL_UpdateTexture(texture_, nullptr, rgb_.data(), TEXTURE_WIDTH * scale_ * sizeof(uint32_t));
   SDL_RenderClear(renderer_);
 
   // Lock aspect ratio to TEXTURE_HEIGHT/TEXTURE_WIDTH
@@ -41,6 +60,11 @@ void ui::Screen::update(const uint32_t* pixels) {
   SDL_RenderPresent(renderer_);
 }
 
+unsigned ui::Screen::fitScale() const {
+  const unsigned scale = std::min(width_ / TEXTURE_WIDTH, height_ / TEXTURE_HEIGHT);
+  return std::clamp(scale, 1u, hw::palette::MAX_SCALE);
+}
+
 void ui::Screen::handleEvent(SDL_Event& event) {
   if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_l) {
     lock_aspect_ratio_ = !lock_aspect_ratio_;
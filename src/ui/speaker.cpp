@@ -13,13 +13,12 @@ extern "C" void cb_trampoline(void* userdata, uint8_t* stream, int len) {
 void ui::audio_callback(ui::Speaker* speaker, uint8_t* stream, size_t len) {
   const size_t available = SDL_AudioStreamAvailable(speaker->downsampler_);
 
-  static bool startup_complete = false;
-  if (!startup_complete) {
-    if (available < ui::Speaker::TARGET_AUDIO_BUFFER_LEN) {
+  if (!speaker->startup_complete_) {
+    if (available < speaker->targetBufferLen()) {
       memset(stream, 0, len);
       return;
     } else {
-      startup_complete = true;
+      speaker->startup_complete_ = true;
     }
   }
 
@@ -34,6 +33,13 @@ void ui::audio_callback(ui::Speaker* speaker, uint8_t* stream, size_t len) {
   size_t copied = std::min<size_t>(len, available);
   SDL_AudioStreamGet(speaker->downsampler_, stream, copied);
 
+  // With dynamic rate control the buffer level is held by the emulation speed instead. If it does run dry, hold the
+  // last sample rather than clicking
+  if (speaker->dynamic_rate_) {
+    memset(stream + copied, stream[copied - 1], len - copied);
+    return;
+  }
+
   // Drop samples as required from the input buffer to maintain the target buffer length
   // This compensates for extra frames added when the buffer runs dry or the system runs over 100% speed (uncapped)
   if (available > ui::Speaker::TARGET_AUDIO_BUFFER_LEN) {
@@ -103,22 +109,18 @@ void ui::Speaker::close() {
 }
 
 void ui::Speaker::update(uint8_t* stream, size_t len) {
-  constexpr size_t UPSAMPLE_B = 100;
-  static uint8_t   upsample_buffer[UPSAMPLE * UPSAMPLE_B];
-  static uint8_t   buffer_size = 0;
-
   // Upscale by 11 and feed the downsampler
   // Note that feeding the downsampler is slow, so feed it 11*10 at a time
   for (size_t i = 0; i < len; i++) {
-    SDL_memset(&upsample_buffer[UPSAMPLE * buffer_size++], stream[i] * volume_, UPSAMPLE);
+    SDL_memset(&upsample_buffer_[UPSAMPLE * upsample_size_++], stream[i] * volume_, UPSAMPLE);
 
-    if (buffer_size == UPSAMPLE_B) {
+    if (upsample_size_ == UPSAMPLE_BATCH) {
       SDL_LockAudioDevice(device_);
-      if (0 != SDL_AudioStreamPut(downsampler_, upsample_buffer, UPSAMPLE * UPSAMPLE_B)) {
+      if (0 != SDL_AudioStreamPut(downsampler_, upsample_buffer_, UPSAMPLE * UPSAMPLE_BATCH)) {
         logger::log<logger::ERROR>("Failed to put samples in first downsampler: %s\n", SDL_GetError());
       }
       SDL_UnlockAudioDevice(device_);
-      buffer_size = 0;
+      upsample_size_ = 0;
     }
   }
 
@@ -128,6 +130,16 @@ void ui::Speaker::update(uint8_t* stream, size_t len) {
   // TODO: 14kHz first-order low-pass
 }
 
+void ui::Speaker::updateRate() {
+  SDL_LockAudioDevice(device_);
+  const size_t available = SDL_AudioStreamAvailable(downsampler_);
+  SDL_UnlockAudioDevice(device_);
+
+  // Run slightly fast when the buffer is below target, and slightly slow when above
+  buffer_level_    = static_cast<float>(available) / targetBufferLen();
+  rate_adjustment_ = 1 + std::max(std::min(1 - buffer_level_, 1.f), -1.f) * MAX_RATE_DELTA;
+}
+
 void ui::Speaker::pause(bool pause) {
   SDL_PauseAudioDevice(device_, pause);
 }
@@ -1,8 +1,8 @@
 #include <nesemu/ui/sprite_viewer.h>
 
+#include <nesemu/hw/palette.h>
 #include <nesemu/hw/ppu.h>
 #include <nesemu/logger.h>
-#include <nesemu/temp_mapping.h>
 
 
 void ui::SpriteViewer::update() {
@@ -10,9 +10,6 @@ void ui::SpriteViewer::update() {
     return;
   }
 
-  // Screen buffer
-  static uint32_t* pixels = new uint32_t[TEXTURE_WIDTH * TEXTURE_HEIGHT];
-
   // Iterate over every sprite in the OAM
   for (uint8_t row = 0; row < 8; row++) {
     for (uint8_t col = 0; col < 8; col++) {
@@ -25,22 +22,23 @@ void ui::SpriteViewer::update() {
 
       // Tile row
       for (uint8_t i = 0; i < 8; i++) {
-        const uint8_t ptrn_a = ppu_->readByte((pattern_addr + i));
-        const uint8_t ptrn_b = ppu_->readByte((pattern_addr + i) | 8);
+        const uint8_t ptrn_a = ppu_->peekByte((pattern_addr + i));
+        const uint8_t ptrn_b = ppu_->peekByte((pattern_addr + i) | 8);
 
         // Tile col
         for (uint8_t j = 0; j < 8; j++) {
           const uint8_t  pixel        = ((ptrn_a >> (7 - j)) & 0x01) | (((ptrn_b >> (7 - j)) << 1) & 0x02);
           const uint16_t palette_addr = pixel | (sprite.attributes.palette << 2) | 0x10;
 
-          pixels[(row * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] = decodeColor(ppu_->readByte(0x3F00 | palette_addr));
+          pixels_[(row * 8 + i) * TEXTURE_WIDTH + (col * 8 + j)] =
+              (*colors_)[ppu_->peekByte(0x3F00 | palette_addr) & 0x3F];
         }
       }
     }
   }
 
   // Draw the nametable to the screen, with locked aspect ratio TEXTURE_HEIGHT/TEXTURE_WIDTH
-  SDL_UpdateTexture(texture_, nullptr, pixels, TEXTURE_WIDTH * sizeof(uint32_t));
+  SDL_UpdateTexture(texture_, nullptr, pixels_.data(), TEXTURE_WIDTH * sizeof(uint32_t));
   SDL_RenderClear(renderer_);
   SDL_Rect dest;
   if (width_ * TEXTURE_HEIGHT < height_ * TEXTURE_WIDTH) {
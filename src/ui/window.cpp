@@ -64,10 +64,9 @@ void ui::Window::close() {
 void ui::Window::update() {
   if (visible_) {
 
-    static bool warned = false;
-    if (!warned) {
+    if (!warned_) {
       logger::log<logger::WARNING>("Window %s does not override the update() method!\n", title_.c_str());
-      warned = true;
+      warned_ = true;
     }
     SDL_SetRenderDrawColor(renderer_, 0xFF, 0xFF, 0xFF, 0xFF);
     SDL_RenderClear(renderer_);
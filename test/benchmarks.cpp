@@ -0,0 +1,174 @@
+#include "harness.h"
+
+#include <nesemu/hw/console.h>
+#include <nesemu/hw/io.h>
+#include <nesemu/hw/palette.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>  // memcmp
+#include <string>
+#include <vector>
+
+
+/// Run the rom unthrottled with the mapper-specialised console, then with the generic one, and compare their speeds.
+/// The cartridge's RAM lives in the rom, so each run loads its own copy, to start from the same state
+int test::benchmark(const Options& options, unsigned frames) {
+  double fps[2] = {0};
+
+  for (const bool generic : {false, true}) {
+    Console console;
+    if (console.open(options, generic)) {
+      return 1;
+    }
+    console->start();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned i = 0; i < frames; i++) {
+      console->runFrame();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const double                        skipped = 100.0 * console->getSkippedCycles() / console->getCycles();
+
+    fps[generic] = frames / elapsed.count();
+    printf("%-12s %u frames in %.3fs, %.1f fps",
+           generic ? "Generic:" : "Specialised:",
+           frames,
+           elapsed.count(),
+           fps[generic]);
+    if (options.idle_skip) {
+      printf(", %.1f%% of cycles skipped", skipped);
+    }
+    printf("\n");
+  }
+
+  printf("Speedup:     %.2fx\n", fps[0] / fps[1]);
+  return 0;
+}
+
+/// Time each palette conversion kernel at each scale, on a frame from the rom. Every kernel's output is checked against
+/// the scalar kernel's
+int test::benchmarkKernels(const Options& options, unsigned frames) {
+  static constexpr unsigned    ITERATIONS = 200;
+  static constexpr const char* NAMES[]    = {"Scalar", "SSE2", "AVX2"};
+  static constexpr std::size_t FRAME_SIZE = hw::palette::WIDTH * hw::palette::HEIGHT;
+
+  FrameCapture screen;
+  {
+    Console console;
+    if (console.open(options)) {
+      return 1;
+    }
+    console->setScreen(&screen);
+    console->start();
+    for (unsigned i = 0; i < frames; i++) {
+      console->runFrame();
+    }
+  }
+
+  hw::palette::Palette  reference;
+  std::vector<uint32_t> expected(FRAME_SIZE * hw::palette::MAX_SCALE * hw::palette::MAX_SCALE);
+  std::vector<uint32_t> actual(expected.size());
+  reference.setKernel(hw::palette::Kernel::SCALAR);
+
+  printf("ns/frame");
+  for (unsigned scale = 1; scale <= hw::palette::MAX_SCALE; scale++) {
+    printf("  %8ux", scale);
+  }
+  printf("\n");
+
+  int result = 0;
+  for (const auto kernel : {hw::palette::Kernel::SCALAR, hw::palette::Kernel::SSE2, hw::palette::Kernel::AVX2}) {
+    hw::palette::Palette palette;
+    printf("%-8s", NAMES[static_cast<unsigned>(kernel)]);
+    if (palette.setKernel(kernel)) {
+      printf("  not supported by this CPU\n");
+      continue;
+    }
+
+    for (unsigned scale = 1; scale <= hw::palette::MAX_SCALE; scale++) {
+      const auto start = std::chrono::steady_clock::now();
+      for (unsigned i = 0; i < ITERATIONS; i++) {
+        palette.convert(screen.pixels_, actual.data(), scale);
+      }
+      const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+      reference.convert(screen.pixels_, expected.data(), scale);
+      if (std::memcmp(expected.data(), actual.data(), FRAME_SIZE * scale * scale * sizeof(uint32_t)) == 0) {
+        printf("  %9.0f", elapsed.count() / ITERATIONS);
+      } else {
+        printf("  %9s", "MISMATCH");
+        result = 1;
+      }
+    }
+    printf("\n");
+  }
+  return result;
+}
+
+/// Converts every frame drawn to RGB, as the screen would
+class FrameConverter : public hw::io::VideoSink {
+public:
+  void update(const uint16_t* pixels) override {
+    palette_.convert(pixels, rgb_.data());
+    drawn_++;
+  }
+
+  hw::palette::Palette  palette_;
+  std::vector<uint32_t> rgb_   = std::vector<uint32_t>(hw::palette::WIDTH * hw::palette::HEIGHT);
+  uint64_t              drawn_ = {0};
+};
+
+/// Run the rom unthrottled, drawing every 1st, 2nd and 4th frame, and none at all, and compare their speeds. Skipped
+/// frames must leave the CPU and PPU in the same state as drawn ones, so that is checked after each run
+int test::benchmarkFrameSkip(const Options& options, unsigned frames) {
+  static constexpr uint32_t RATIOS[] = {1, 2, 4, 0};
+
+  hw::cpu::Registers cpu_expected = {};
+  hw::ppu::Registers ppu_expected = {};
+  uint64_t           cycles       = 0;
+  double             fps[4]       = {0};
+
+  int result = 0;
+  for (unsigned i = 0; i < 4; i++) {
+    FrameConverter screen;
+    Console        console;
+    if (console.open(options)) {
+      return 1;
+    }
+    console->setScreen(&screen);
+    console->setFrameSkip(RATIOS[i]);
+    console->start();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned frame = 0; frame < frames; frame++) {
+      console->runFrame();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    fps[i] = frames / elapsed.count();
+    printf("Ratio %-4s %u frames in %.3fs, %.1f fps, %llu drawn",
+           RATIOS[i] ? std::to_string(RATIOS[i]).c_str() : "inf",
+           frames,
+           elapsed.count(),
+           fps[i],
+           static_cast<unsigned long long>(screen.drawn_));
+
+    if (i == 0) {
+      cpu_expected = console->getRegisters();
+      ppu_expected = console->getPPU()->registers();
+      cycles       = console->getCycles();
+    } else if (console->getCycles() != cycles || console->getRegisters() != cpu_expected
+               || console->getPPU()->registers() != ppu_expected) {
+      printf(", CPU or PPU state differs from ratio 1");
+      result = 1;
+    }
+    printf("\n");
+  }
+
+  printf("Speedup:   %.2fx at ratio 2, %.2fx at ratio 4, %.2fx at ratio inf\n",
+         fps[1] / fps[0],
+         fps[2] / fps[0],
+         fps[3] / fps[0]);
+  return result;
+}
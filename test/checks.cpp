@@ -0,0 +1,411 @@
+#include "harness.h"
+
+#include <nesemu/hw/console.h>
+#include <nesemu/hw/io.h>
+#include <nesemu/hw/rewind.h>
+#include <nesemu/logger.h>
+
+#include <algorithm>  // std::max
+#include <chrono>
+#include <cstdio>
+#include <cstring>  // memcmp
+#include <thread>
+#include <vector>
+
+
+/// Run the rom on the block backend and the interpreter in lockstep, comparing the CPU state whenever they have run the
+/// same number of cycles. Only the block backend skips idle loops, so the interpreter checks them too
+int test::differential(const Options& options, unsigned frames) {
+  Console blocks;
+  Console interpreter;
+  if (blocks.open(options) || interpreter.open(options)) {
+    return 1;
+  }
+  blocks->setBackend(hw::cpu::Backend::BLOCKS);
+  interpreter->setBackend(hw::cpu::Backend::INTERPRETER);
+  blocks->start();
+  interpreter->start();
+
+  int result = 0;
+  while (blocks->getFrameCount() < frames) {
+    blocks->update();
+    while (interpreter->getCycles() < blocks->getCycles()) {
+      interpreter->update();
+    }
+
+    const hw::cpu::Registers expected = interpreter->getRegisters();
+    const hw::cpu::Registers actual   = blocks->getRegisters();
+    if (interpreter->getCycles() != blocks->getCycles() || actual != expected) {
+      printf("Mismatch in frame %llu:\n", static_cast<unsigned long long>(blocks->getFrameCount()));
+      printf("  Interpreter: cycle %llu PC=$%04X SP=$%02X A=$%02X X=$%02X Y=$%02X P=$%02X\n",
+             static_cast<unsigned long long>(interpreter->getCycles()),
+             expected.pc,
+             expected.sp,
+             expected.a,
+             expected.x,
+             expected.y,
+             expected.p);
+      printf("  Blocks:      cycle %llu PC=$%04X SP=$%02X A=$%02X X=$%02X Y=$%02X P=$%02X\n",
+             static_cast<unsigned long long>(blocks->getCycles()),
+             actual.pc,
+             actual.sp,
+             actual.a,
+             actual.x,
+             actual.y,
+             actual.p);
+      result = 1;
+      break;
+    }
+  }
+
+  if (result == 0) {
+    printf("No differences in %u frames", frames);
+    if (options.idle_skip) {
+      printf(", %llu cycles skipped", static_cast<unsigned long long>(blocks->getSkippedCycles()));
+    }
+    printf("\n");
+  }
+  return result;
+}
+
+/// Run the rom with the PPU drawing a dot at a time, and a scanline at a time, comparing the frames drawn and the
+/// state the CPU can see after every frame
+int test::checkRender(const Options& options, unsigned frames) {
+  Console      dots;
+  Console      scanlines;
+  FrameCapture screens[2];
+  if (dots.open(options) || scanlines.open(options)) {
+    return 1;
+  }
+  dots->setScreen(&screens[0]);
+  scanlines->setScreen(&screens[1]);
+  dots->setRenderer(hw::ppu::Renderer::DOTS);
+  scanlines->setRenderer(hw::ppu::Renderer::SCANLINES);
+  dots->start();
+  scanlines->start();
+
+  int result = 0;
+  for (unsigned frame = 0; frame < frames; frame++) {
+    dots->runFrame();
+    scanlines->runFrame();
+
+    const hw::ppu::Registers expected = dots->getPPU()->registers();
+    const hw::ppu::Registers actual   = scanlines->getPPU()->registers();
+    const bool same_cpu    = dots->getCycles() == scanlines->getCycles()
+                          && dots->getRegisters() == scanlines->getRegisters();
+    const bool same_pixels = std::memcmp(screens[0].pixels_, screens[1].pixels_, sizeof(screens[0].pixels_)) == 0;
+    if (!same_cpu || actual != expected || !same_pixels) {
+      printf("Mismatch in frame %u (pixels %s, CPU %s):\n",
+             frame,
+             same_pixels ? "match" : "differ",
+             same_cpu ? "matches" : "differs");
+      printf("  Dots:      cycle %llu v=$%04X t=$%04X x=%u status=$%02X dot %u,%u\n",
+             static_cast<unsigned long long>(dots->getCycles()),
+             expected.v,
+             expected.t,
+             expected.fine_x,
+             expected.status,
+             expected.scanline,
+             expected.cycle);
+      printf("  Scanlines: cycle %llu v=$%04X t=$%04X x=%u status=$%02X dot %u,%u\n",
+             static_cast<unsigned long long>(scanlines->getCycles()),
+             actual.v,
+             actual.t,
+             actual.fine_x,
+             actual.status,
+             actual.scanline,
+             actual.cycle);
+      result = 1;
+      break;
+    }
+  }
+
+  if (result == 0) {
+    printf("No differences in %u frames\n", frames);
+  }
+  return result;
+}
+
+/// Run the rom on several consoles at once, each on its own thread, and check that they all end up in the same state.
+/// Consoles share nothing, so any difference (or a data race, when built with SANITIZE_THREAD) is a bug
+int test::runThreads(const Options& options, unsigned consoles) {
+  static constexpr unsigned FRAMES = 600;
+
+  struct Result {
+    bool               ran       = {false};  // Whether the rom loaded, and the console ran
+    uint64_t           cycles    = {0};
+    hw::cpu::Registers registers = {};
+    uint64_t           output    = {0};  // See OutputHash
+  };
+  std::vector<Result>      results(consoles);
+  std::vector<std::thread> threads;
+  const logger::Level      log_level = logger::level;  // Each thread has its own
+
+  const auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < consoles; i++) {
+    threads.emplace_back([&, i]() {
+      logger::level = log_level;
+      Console console;
+      if (console.open(options)) {
+        return;
+      }
+      console.hashOutput();
+      console->start();
+      for (unsigned frame = 0; frame < FRAMES; frame++) {
+        console->runFrame();
+      }
+      results[i] = {true, console->getCycles(), console->getRegisters(), console.output_.hash_};
+    });
+  }
+  for (auto&& thread : threads) {
+    thread.join();
+  }
+  const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  int result = 0;
+  for (unsigned i = 0; i < consoles; i++) {
+    const Result& expected = results[0];
+    const Result& actual   = results[i];
+    if (!actual.ran || actual.cycles != expected.cycles || actual.registers != expected.registers
+        || actual.output != expected.output) {
+      printf("Console %u differs from console 0\n", i);
+      result = 1;
+    }
+  }
+
+  printf("%u consoles x %u frames in %.3fs, %.1f fps in total\n",
+         consoles,
+         FRAMES,
+         elapsed.count(),
+         consoles * FRAMES / elapsed.count());
+  return result;
+}
+
+/// Check that save states round trip: save a state, load it into a second console, and run both. They must produce the
+/// same audio and end up in the same state. States saved at the end of a frame must also produce the same frames,
+/// which isn't true mid-frame, as the screen buffer isn't saved. Then time snapshots and restores
+int test::checkSaveStates(const Options& options, unsigned frames) {
+  static constexpr uint64_t MID_FRAME = 10007;  // CPU cycles into the frame, for the second state
+
+  Console consoles[2];
+  for (Console& console : consoles) {
+    if (console.open(options)) {
+      return 1;
+    }
+    console->start();
+  }
+  Console& original = consoles[0];
+  Console& restored = consoles[1];
+
+  int                  result = 0;
+  std::vector<uint8_t> saved;
+  std::vector<uint8_t> expected;
+  std::vector<uint8_t> actual;
+  for (unsigned frame = 0; frame < frames; frame++) {
+    original->runFrame();
+  }
+
+  for (const bool mid_frame : {false, true}) {
+    const char* when = mid_frame ? "mid-frame" : "at the end of a frame";
+    if (mid_frame) {
+      original->runCycles(MID_FRAME);
+    }
+
+    original->saveState(&saved);
+    if (restored->loadState(saved)) {
+      return 1;
+    }
+
+    restored->saveState(&actual);
+    if (actual != saved) {
+      printf("  Saving the loaded state %s gives a different state\n", when);
+      result = 1;
+    }
+
+    OutputHash video[2];
+    OutputHash audio[2];
+    for (unsigned i = 0; i < 2; i++) {
+      consoles[i]->setScreen(&video[i]);
+      consoles[i]->setSpeaker(&audio[i]);
+      for (unsigned frame = 0; frame < frames; frame++) {
+        consoles[i]->runFrame();
+      }
+      consoles[i]->setScreen(nullptr);
+      consoles[i]->setSpeaker(nullptr);
+    }
+
+    original->saveState(&expected);
+    restored->saveState(&actual);
+    if (actual != expected || restored->getRegisters() != original->getRegisters()) {
+      printf("  After loading a state %s, the consoles end up in different states\n", when);
+      result = 1;
+    }
+    if (audio[1].hash_ != audio[0].hash_) {
+      printf("  After loading a state %s, the audio differs\n", when);
+      result = 1;
+    }
+    if (!mid_frame && video[1].hash_ != video[0].hash_) {
+      printf("  After loading a state %s, the frames differ\n", when);
+      result = 1;
+    }
+  }
+
+  if (result == 0) {
+    printf("Save states round trip, %u frames after each\n", frames);
+  }
+
+  // Time snapshots and restores as rolling back uses them, with the buffer reused. Restoring the state the console is
+  // already in is the best case, as nothing the restore rebuilds has changed. Rolling back restores a state from a few
+  // frames before, so also alternate between two snapshots that far apart
+  static constexpr unsigned SNAPSHOTS       = 100000;
+  static constexpr unsigned ROLLBACK_FRAMES = 4;  // Between the alternated snapshots
+
+  std::vector<uint8_t> earlier;
+  original->snapshot(&earlier);
+  for (unsigned frame = 0; frame < ROLLBACK_FRAMES; frame++) {
+    original->runFrame();
+  }
+
+  const auto snapshot_start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < SNAPSHOTS; i++) {
+    original->snapshot(&saved);
+  }
+  const auto restore_start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < SNAPSHOTS; i++) {
+    original->restore(saved);
+  }
+  const auto alternate_start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < SNAPSHOTS; i++) {
+    original->restore((i & 1) ? saved : earlier);
+  }
+  const auto alternate_end = std::chrono::steady_clock::now();
+
+  const std::chrono::duration<double, std::nano> snapshot_time  = restore_start - snapshot_start;
+  const std::chrono::duration<double, std::nano> restore_time   = alternate_start - restore_start;
+  const std::chrono::duration<double, std::nano> alternate_time = alternate_end - alternate_start;
+  printf("%zu byte snapshots: %.0fns per snapshot, %.0fns per restore of the same snapshot, %.0fns per restore "
+         "alternating between two %u frames apart\n",
+         saved.size(),
+         snapshot_time.count() / SNAPSHOTS,
+         restore_time.count() / SNAPSHOTS,
+         alternate_time.count() / SNAPSHOTS,
+         ROLLBACK_FRAMES);
+  return result;
+}
+
+/// Presses the buttons it's given, which the caller changes between frames, like a player
+class ScriptedInput : public hw::io::InputSource {
+public:
+  uint8_t poll(uint8_t port) override { return buttons_[port - 1]; }
+
+  uint8_t buttons_[2] = {0};
+};
+
+/// Check rewinding: run the rom with buttons pressed, capturing every frame and timing each capture, then step back
+/// through every frame kept, replaying each, and run forward again from the oldest. Every frame's state must match the
+/// one captured the first time, and every replayed frame must draw the same picture
+int test::checkRewind(const Options& options, unsigned frames) {
+  static constexpr double FRAME_TIME = 1e6 / 60.0988;  // us
+
+  Console console;
+  if (console.open(options)) {
+    return 1;
+  }
+  console->start();
+
+  hw::rewind::Rewind rewind(options.rewind_budget, options.keyframe_interval);
+  ScriptedInput      input;
+  rewind.setInput(&input);
+  console->setInput(&rewind);
+  const auto press = [&](unsigned frame) {
+    input.buttons_[0] = (frame / 8) * 0x9D;  // A different set of buttons every 8 frames
+    input.buttons_[1] = (frame / 8) * 0x3B;
+  };
+
+  std::vector<uint64_t> hashes(frames);    // Of each frame's state
+  std::vector<uint64_t> pictures(frames);  // Of each frame drawn
+
+  using Microseconds = std::chrono::duration<double, std::micro>;
+  Microseconds capture_total = {};
+  Microseconds capture_max   = {};
+  for (unsigned frame = 0; frame < frames; frame++) {
+    OutputHash picture;
+    press(frame);
+    console->setScreen(&picture);
+    console->runFrame();
+    console->setScreen(nullptr);
+    const auto start = std::chrono::steady_clock::now();
+    rewind.capture(console.get());
+    const Microseconds elapsed = std::chrono::steady_clock::now() - start;
+    capture_total += elapsed;
+    capture_max     = std::max(capture_max, elapsed);
+    hashes[frame]   = console.hashState();
+    pictures[frame] = picture.hash_;
+  }
+
+  const std::size_t kept = rewind.frames();
+  printf("Kept %zu of %u frames (%.1fs) in %.2f of %.2fMiB, %zu keyframes, %zu byte states\n",
+         kept,
+         frames,
+         kept / 60.0988,
+         rewind.bytesUsed() / 1048576.0,
+         options.rewind_budget / 1048576.0,
+         rewind.keyframes(),
+         console.lastState().size());
+  printf("Capture:   %.2fus mean, %.2fus max, %.4f%% of a frame\n",
+         capture_total.count() / frames,
+         capture_max.count(),
+         100.0 * capture_total.count() / frames / FRAME_TIME);
+  if (kept < 2) {
+    printf("  Not enough frames kept to step back, the budget must fit a keyframe and a delta\n");
+    return 1;
+  }
+
+  int          result     = 0;
+  Microseconds step_total = {};
+  Microseconds step_max   = {};
+  for (std::size_t age = 1; age < kept && result == 0; age++) {
+    const auto start = std::chrono::steady_clock::now();
+    rewind.stepBack(console.get());
+    const Microseconds elapsed = std::chrono::steady_clock::now() - start;
+    step_total += elapsed;
+    step_max = std::max(step_max, elapsed);
+    if (console.hashState() != hashes[frames - 1 - age]) {
+      printf("  Stepping back %zu frames gives a different state\n", age);
+      result = 1;
+    }
+    if (rewind.frames() < 2) {
+      break;  // The oldest, which can't be replayed
+    }
+
+    OutputHash picture;
+    console->setScreen(&picture);
+    rewind.replay(console.get());
+    console->setScreen(nullptr);
+    if (picture.hash_ != pictures[frames - 1 - age] || console.hashState() != hashes[frames - 1 - age]) {
+      printf("  Replaying the frame %zu frames back gives a different frame\n", age);
+      result = 1;
+    }
+  }
+  printf("Step back: %.2fus mean, %.2fus max\n", step_total.count() / (kept - 1), step_max.count());
+
+  for (unsigned frame = frames - kept + 1; frame < frames && result == 0; frame++) {
+    press(frame);
+    console->runFrame();
+    rewind.capture(console.get());
+    if (console.hashState() != hashes[frame]) {
+      printf("  Running forward again, frame %u has a different state\n", frame);
+      result = 1;
+    }
+  }
+  if (result == 0
+      && (rewind.load(console.get(), kept / 2) || console.hashState() != hashes[frames - 1 - kept / 2])) {
+    printf("  Loading the frame %zu frames back gives a different state\n", kept / 2);
+    result = 1;
+  }
+
+  if (result == 0) {
+    printf("Rewinding matches every frame\n");
+  }
+  return result;
+}
@@ -0,0 +1,33 @@
+#include "harness.h"
+
+#include <cstring>  // memcpy
+
+
+void test::FrameCapture::update(const uint16_t* pixels) {
+  std::memcpy(pixels_, pixels, sizeof(pixels_));
+}
+
+int test::Console::open(const Options& options, bool generic) {
+  if (hw::rom::parseFromFile(options.filename, &rom_)) {
+    return 1;
+  }
+  console_ = hw::console::create(&rom_, options.allow_unofficial, generic);
+  if (!console_) {
+    return 1;
+  }
+  console_->limitSpeed(false);
+  console_->skipIdleLoops(options.idle_skip);
+  return 0;
+}
+
+void test::Console::hashOutput() {
+  console_->setScreen(&output_);
+  console_->setSpeaker(&output_);
+}
+
+uint64_t test::Console::hashState() {
+  OutputHash hash;
+  console_->snapshot(&state_);
+  hash.update(state_.data(), state_.size());
+  return hash.hash_;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <nesemu/hw/console.h>
+#include <nesemu/hw/io.h>
+#include <nesemu/hw/rom.h>
+
+#include <cstddef>  // size_t
+#include <cstdint>  // uint8_t, uint16_t, uint64_t
+#include <string>
+#include <vector>
+
+
+// Checks and benchmarks of the core, each run headless on a rom (see main.cpp for the options which pick them). Each
+// returns non-zero if the check failed, or the rom couldn't be run
+namespace test {
+
+// Settings shared by every check
+struct Options {
+  std::string filename;
+  bool        allow_unofficial  = {true};
+  bool        idle_skip         = {false};     // See hw::console::Console::skipIdleLoops
+  std::size_t rewind_budget     = {16 << 20};  // Bytes, see hw::rewind::Rewind
+  unsigned    keyframe_interval = {60};        // Frames
+};
+
+
+// Hashes every frame drawn and every audio sample (FNV-1a), so that runs can be compared without keeping their output
+class OutputHash : public hw::io::VideoSink, public hw::io::AudioSink {
+public:
+  void update(const uint16_t* pixels) override { hash(pixels, 256 * 240 * sizeof(uint16_t)); }
+  void update(uint8_t* stream, size_t len) override { hash(stream, len); }
+
+  uint64_t hash_ = {14695981039346656037ull};
+
+private:
+  void hash(const void* data, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+      hash_ = (hash_ ^ static_cast<const uint8_t*>(data)[i]) * 1099511628211ull;
+    }
+  }
+};
+
+// Keeps a copy of the last frame drawn
+class FrameCapture : public hw::io::VideoSink {
+public:
+  void update(const uint16_t* pixels) override;
+
+  uint16_t pixels_[256 * 240] = {0};
+};
+
+
+// A console to check, with its own copy of the rom. Consoles write to their rom's CHR and save RAM, so any which are
+// compared can't share one. Runs unthrottled, skipping idle loops if the options ask for it
+class Console {
+public:
+  Console() = default;
+  Console(const Console&) = delete;
+  Console& operator=(const Console&) = delete;
+  ~Console() { delete console_; }
+
+  // Load the rom and create the console, specialised on its mapper unless generic is set (see hw::console::create).
+  // Returns non-zero if the rom can't be run. Attach any sinks, then start() it
+  int open(const Options& options, bool generic = false);
+
+  void                        hashOutput();  // Hash every frame drawn and every audio sample into output_
+  uint64_t                    hashState();   // Of a snapshot of the current state (see hw::console::Console::snapshot)
+  const std::vector<uint8_t>& lastState() const { return state_; }  // The snapshot last hashed
+
+  hw::console::Console* operator->() const { return console_; }
+  hw::console::Console* get() const { return console_; }
+
+  OutputHash output_;
+
+private:
+  hw::rom::Rom          rom_     = {};
+  hw::console::Console* console_ = {nullptr};
+  std::vector<uint8_t>  state_;
+};
+
+
+// Checks, see checks.cpp
+int differential(const Options& options, unsigned frames);
+int checkRender(const Options& options, unsigned frames);
+int runThreads(const Options& options, unsigned consoles);
+int checkSaveStates(const Options& options, unsigned frames);
+int checkRewind(const Options& options, unsigned frames);
+
+// Benchmarks, see benchmarks.cpp. These check their runs against each other too
+int benchmark(const Options& options, unsigned frames);
+int benchmarkKernels(const Options& options, unsigned frames);
+int benchmarkFrameSkip(const Options& options, unsigned frames);
+
+}  // namespace test
@@ -0,0 +1,178 @@
+#include "harness.h"
+
+#include <nesemu/logger.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <getopt.h>
+#include <string>
+
+
+void printUsage() {
+  printf("Usage: nesemu_test [options]... file.nes\n");
+  printf("Runs each check and benchmark asked for headless on the rom, in this order, and\n");
+  printf("exits non-zero if any of them fails\n");
+  printf("  -h --help               print this usage and exit\n");
+  printf("  -b --benchmark[=frames] run the specified number of frames unthrottled, with\n");
+  printf("                          and without the mapper-specialised console.\n");
+  printf("                          Default 600 frames\n");
+  printf("  -c --check-render[=frames]\n");
+  printf("                          run the specified number of frames with both PPU\n");
+  printf("                          renderers, stopping at the first frame which\n");
+  printf("                          differs. Default 600 frames\n");
+  printf("  -d --diff[=frames]      run the specified number of frames on both CPU\n");
+  printf("                          backends in lockstep, stopping at the first\n");
+  printf("                          difference in CPU state. Default 600 frames. With -i,\n");
+  printf("                          only the block backend skips idle loops\n");
+  printf("  -F --frame-skip[=frames]\n");
+  printf("                          run the specified number of frames unthrottled,\n");
+  printf("                          drawing every 1st, 2nd, 4th and no frame, checking\n");
+  printf("                          that each ends in the same state. Default 600 frames\n");
+  printf("  -k --kernels[=frames]   time converting a frame to RGB at each scale, with\n");
+  printf("                          each kernel the CPU supports, after running the\n");
+  printf("                          specified number of frames. Default 60\n");
+  printf("  -t --threads[=consoles] run the specified number of consoles unthrottled for\n");
+  printf("                          600 frames, each on its own thread, checking that\n");
+  printf("                          they all end up in the same state. Default 16\n");
+  printf("                          consoles\n");
+  printf("  -S --save-states[=frames]\n");
+  printf("                          run the specified number of frames, save a state,\n");
+  printf("                          and load it into a second console, checking that\n");
+  printf("                          both then produce the same frames and audio and end\n");
+  printf("                          up in the same state, then time snapshots and\n");
+  printf("                          restores, both of one snapshot and alternating\n");
+  printf("                          between two a few frames apart. Default 600 frames\n");
+  printf("  -R --check-rewind[=frames]\n");
+  printf("                          run the specified number of frames with buttons\n");
+  printf("                          pressed, keeping them for rewinding and timing each\n");
+  printf("                          capture, then step back through them, replaying\n");
+  printf("                          each, and run forward again, checking every frame's\n");
+  printf("                          state and picture. Default 600 frames\n");
+  printf("  -i --idle-skip          fast-forward through loops which are only waiting\n");
+  printf("                          for an interrupt or VBlank\n");
+  printf("  -o --official           allow unofficial opcodes\n");
+  printf("  -r --rewind=MiB         for -R, keep frames in the specified amount of\n");
+  printf("                          memory. Default 16MiB\n");
+  printf("  -K --keyframes=frames   for -R, keep every specified number of frames whole.\n");
+  printf("                          Default 60 frames\n");
+  printf("  -q --quiet              disable all logging\n");
+}
+
+int main(int argc, char* argv[]) {
+  int           opt = 0;
+  test::Options options;
+  unsigned      benchmark_frames = 0;
+  unsigned      check_frames     = 0;
+  unsigned      diff_frames      = 0;
+  unsigned      skip_frames      = 0;
+  unsigned      kernel_frames    = 0;
+  unsigned      thread_consoles  = 0;
+  unsigned      state_frames     = 0;
+  unsigned      rewind_frames    = 0;
+
+  static struct option long_options[] = {{"benchmark", optional_argument, nullptr, 'b'},
+                                         {"check-render", optional_argument, nullptr, 'c'},
+                                         {"diff", optional_argument, nullptr, 'd'},
+                                         {"frame-skip", optional_argument, nullptr, 'F'},
+                                         {"kernels", optional_argument, nullptr, 'k'},
+                                         {"threads", optional_argument, nullptr, 't'},
+                                         {"save-states", optional_argument, nullptr, 'S'},
+                                         {"check-rewind", optional_argument, nullptr, 'R'},
+                                         {"idle-skip", no_argument, nullptr, 'i'},
+                                         {"official", no_argument, nullptr, 'o'},
+                                         {"rewind", required_argument, nullptr, 'r'},
+                                         {"keyframes", required_argument, nullptr, 'K'},
+                                         {"quiet", no_argument, nullptr, 'q'},
+                                         {"help", no_argument, nullptr, 'h'},
+                                         {0, 0, 0, 0}};
+
+  while ((opt = getopt_long(argc, argv, "b::c::d::F::k::t::S::R::ior:K:qh", long_options, nullptr)) != -1) {
+    switch (opt) {
+      case 'b':  // -b or --benchmark
+        benchmark_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'c':  // -c or --check-render
+        check_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'd':  // -d or --diff
+        diff_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'F':  // -F or --frame-skip
+        skip_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'k':  // -k or --kernels
+        kernel_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 60;
+        break;
+      case 't':  // -t or --threads
+        thread_consoles = optarg ? std::strtoul(optarg, nullptr, 10) : 16;
+        break;
+      case 'S':  // -S or --save-states
+        state_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'R':  // -R or --check-rewind
+        rewind_frames = optarg ? std::strtoul(optarg, nullptr, 10) : 600;
+        break;
+      case 'i':  // -i or --idle-skip
+        options.idle_skip = true;
+        break;
+      case 'o':  // -o or --official
+        options.allow_unofficial = false;
+        break;
+      case 'r':  // -r or --rewind
+        options.rewind_budget = std::strtoull(optarg, nullptr, 10) << 20;
+        break;
+      case 'K':  // -K or --keyframes
+        options.keyframe_interval = std::strtoul(optarg, nullptr, 10);
+        break;
+      case 'q':  // -q or --quiet
+        logger::level = logger::NONE;
+        break;
+
+      case 'h':  // -h or --help
+      case '?':  // Unrecognized option
+      default:
+        printUsage();
+        return 1;
+    }
+  }
+
+  // Parse rom filename
+  if (optind >= argc) {
+    printUsage();
+    return 1;
+  }
+  options.filename = std::string(argv[optind]);
+
+  if (!benchmark_frames && !check_frames && !diff_frames && !skip_frames && !kernel_frames && !thread_consoles
+      && !state_frames && !rewind_frames) {
+    printUsage();
+    return 1;
+  }
+
+  int result = 0;
+  if (benchmark_frames) {
+    result |= test::benchmark(options, benchmark_frames);
+  }
+  if (check_frames) {
+    result |= test::checkRender(options, check_frames);
+  }
+  if (diff_frames) {
+    result |= test::differential(options, diff_frames);
+  }
+  if (skip_frames) {
+    result |= test::benchmarkFrameSkip(options, skip_frames);
+  }
+  if (kernel_frames) {
+    result |= test::benchmarkKernels(options, kernel_frames);
+  }
+  if (thread_consoles) {
+    result |= test::runThreads(options, thread_consoles);
+  }
+  if (state_frames) {
+    result |= test::checkSaveStates(options, state_frames);
+  }
+  if (rewind_frames) {
+    result |= test::checkRewind(options, rewind_frames);
+  }
+  return result;
+}